@@ -31,6 +31,9 @@ class Error {
 
   void Raise();
 
+  Object ToObject() { return Create(); }
+  /**< Return the exception object that Raise() would throw. */
+
   std::string message() { return message_; }
   void set_message(std::string message) { message_ = message; }
 
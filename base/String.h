@@ -48,6 +48,18 @@ public:
         CurrentIsolate(), data, v8::String::kNormalString, length);
   }
 
+  static v8::Local<v8::String> NewFromOneByte(const void* data, int length) {
+    return v8::String::NewFromOneByte(
+        CurrentIsolate(), static_cast<const std::uint8_t*>(data),
+        v8::String::kNormalString, length);
+  }
+
+  static v8::Local<v8::String> NewFromTwoByte(const std::uint16_t* data,
+                                              int length) {
+    return v8::String::NewFromTwoByte(
+        CurrentIsolate(), data, v8::String::kNormalString, length);
+  }
+
  private:
   std::string value_;
 };
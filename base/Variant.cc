@@ -20,6 +20,13 @@
 #include "Base.h"
 #include "conversions/Optional.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "utilities/Mutex.h"
+
 namespace base {
 
 Variant::Variant() {
@@ -245,60 +252,181 @@ std::string Variant::AsJSON() const {
 
 namespace {
 
+/* Buffers of up to kLargestPooled bytes are rounded up to a power of two and
+   recycled through per-size free lists; larger ones go straight to the C
+   library, where calloc() gets zeroed pages from mmap() for free.  Every
+   allocation is preceded by a header recording its size class, so that
+   Free() works no matter what length the buffer was last known by. */
 class ArrayBufferAllocator : public v8::ArrayBuffer::Allocator {
  public:
+  static const size_t kSmallestPooled = 16;
+  static const size_t kLargestPooled = 4096;
+  static const unsigned kSizeClasses = 9;
+  static const size_t kMaximumPooledBytes = 1024 * 1024;
+
+  ArrayBufferAllocator()
+      : live_bytes_(0)
+      , live_buffers_(0)
+      , pooled_bytes_(0) {
+    for (unsigned index = 0; index < kSizeClasses + 1; ++index)
+      allocations_[index] = 0;
+  }
+
   virtual void* Allocate(size_t length) override {
-    char* buffer = new char[length];
-    std::fill(buffer, buffer + length, 0);
-    return buffer;
+    return AllocateImpl(length, true);
   }
 
   virtual void* AllocateUninitialized(size_t length) override {
-    return new char[length];
+    return AllocateImpl(length, false);
   }
 
-  virtual void Free(void* data, size_t length) override {
-    delete[] static_cast<char*>(data);
+  virtual void Free(void* data, size_t) override {
+    if (!data)
+      return;
+
+    Header* header = static_cast<Header*>(data) - 1;
+    utilities::Mutex::Lock lock(mutex_);
+
+    live_bytes_ -= header->capacity;
+    --live_buffers_;
+
+    if (header->size_class < kSizeClasses &&
+        pooled_bytes_ + header->capacity <= kMaximumPooledBytes) {
+      pools_[header->size_class].push_back(header);
+      pooled_bytes_ += header->capacity;
+      return;
+    }
+
+    lock.Release();
+    free(header);
   }
-};
 
-ArrayBufferAllocator* array_buffer_allocator;
+  Variant::ArrayBufferStatistics GetStatistics() {
+    utilities::Mutex::Lock lock(mutex_);
+    Variant::ArrayBufferStatistics statistics;
 
-class ArrayBuffer {
- public:
-  ArrayBuffer(v8::Handle<v8::ArrayBuffer> handle,
-              void* data, size_t length)
-      : handle_(v8::Isolate::GetCurrent(), handle),
-        data_(data),
-        length_(length) {
-    handle_.SetWeak(this, Destroy, v8::WeakCallbackType::kParameter);
-    handle->SetAlignedPointerInInternalField(0, this);
+    statistics.live_bytes = live_bytes_;
+    statistics.live_buffers = live_buffers_;
+    statistics.pooled_bytes = pooled_bytes_;
+
+    for (unsigned index = 0; index < kSizeClasses; ++index)
+      statistics.allocations.push_back(
+          std::make_pair(kSmallestPooled << index, allocations_[index]));
+    statistics.large_allocations = allocations_[kSizeClasses];
+
+    return statistics;
   }
 
-  static void Destroy(
-      const v8::WeakCallbackInfo<ArrayBuffer>& data) {
-    ArrayBuffer* array_buffer = data.GetParameter();
-    array_buffer_allocator->Free(array_buffer->data_, array_buffer->length_);
-    delete array_buffer;
+ private:
+  struct Header {
+    size_t capacity;
+    size_t size_class;
+  };
+
+  static unsigned SizeClass(size_t length) {
+    unsigned size_class = 0;
+    while ((kSmallestPooled << size_class) < length)
+      ++size_class;
+    return size_class;
   }
 
-  void* data() const { return data_; }
-  size_t length() const { return length_; }
+  void* AllocateImpl(size_t length, bool initialize) {
+    Header* header = NULL;
+    size_t capacity;
+    unsigned size_class;
 
-  static ArrayBuffer* Get(v8::Handle<v8::ArrayBuffer> value) {
-    if (value->IsExternal()) {
-      return static_cast<ArrayBuffer*>(
-          value->GetAlignedPointerFromInternalField(0));
+    if (length <= kLargestPooled) {
+      size_class = SizeClass(length);
+      capacity = kSmallestPooled << size_class;
     } else {
-      v8::ArrayBuffer::Contents contents(value->Externalize());
-      return new ArrayBuffer(value, contents.Data(), contents.ByteLength());
+      size_class = kSizeClasses;
+      capacity = length;
+    }
+
+    {
+      utilities::Mutex::Lock lock(mutex_);
+
+      if (size_class < kSizeClasses && !pools_[size_class].empty()) {
+        header = pools_[size_class].back();
+        pools_[size_class].pop_back();
+        pooled_bytes_ -= capacity;
+      }
+
+      live_bytes_ += capacity;
+      ++live_buffers_;
+      ++allocations_[size_class];
     }
+
+    if (header) {
+      if (initialize)
+        memset(header + 1, 0, length);
+    } else {
+      if (initialize)
+        header = static_cast<Header*>(calloc(1, sizeof *header + capacity));
+      else
+        header = static_cast<Header*>(malloc(sizeof *header + capacity));
+
+      if (!header) {
+        utilities::Mutex::Lock lock(mutex_);
+        live_bytes_ -= capacity;
+        --live_buffers_;
+        return NULL;
+      }
+
+      header->capacity = capacity;
+      header->size_class = size_class;
+    }
+
+    return header + 1;
+  }
+
+  utilities::Mutex mutex_;
+  std::vector<Header*> pools_[kSizeClasses];
+  size_t live_bytes_;
+  size_t live_buffers_;
+  size_t pooled_bytes_;
+  size_t allocations_[kSizeClasses + 1];
+};
+
+ArrayBufferAllocator* array_buffer_allocator;
+
+/* ArrayBuffers are created in internalized mode: V8 owns the backing store
+   and returns it to array_buffer_allocator when the buffer is collected, so
+   no per-buffer weak handle is needed to track it. */
+v8::Local<v8::ArrayBuffer> NewArrayBuffer(void* data, size_t length) {
+  return v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), data, length,
+                              v8::ArrayBufferCreationMode::kInternalized);
+}
+
+/* Holder for buffers created by MakeExternalArrayBuffer(), whose memory V8
+   can't free itself. */
+class ExternalArrayBuffer {
+ public:
+  ExternalArrayBuffer(v8::Local<v8::ArrayBuffer> handle, void* data,
+                      size_t length, Variant::ReleaseCallback release)
+      : handle_(v8::Isolate::GetCurrent(), handle)
+      , data_(data)
+      , length_(length)
+      , release_(release) {
+    handle_.SetWeak(this, Destroy, v8::WeakCallbackType::kParameter);
+    CurrentIsolate()->AdjustAmountOfExternalAllocatedMemory(
+        static_cast<std::int64_t>(length));
+  }
+
+  static void Destroy(const v8::WeakCallbackInfo<ExternalArrayBuffer>& data) {
+    ExternalArrayBuffer* buffer = data.GetParameter();
+    buffer->handle_.Reset();
+    buffer->release_(buffer->data_, buffer->length_);
+    CurrentIsolate()->AdjustAmountOfExternalAllocatedMemory(
+        -static_cast<std::int64_t>(buffer->length_));
+    delete buffer;
   }
 
  private:
   v8::Persistent<v8::ArrayBuffer> handle_;
   void* data_;
   size_t length_;
+  Variant::ReleaseCallback release_;
 };
 
 }
@@ -308,20 +436,39 @@ Object Variant::MakeArrayBuffer(const void* data_in, size_t length) {
   std::copy(static_cast<const char*>(data_in),
             static_cast<const char*>(data_in) + length,
             static_cast<char*>(data));
-  v8::Handle<v8::ArrayBuffer> value =
-      v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), data, length);
-  new ArrayBuffer(value, data, length);
-  return value;
+  return NewArrayBuffer(data, length);
 }
 
 Object Variant::MakeArrayBuffer(size_t length) {
   void* data = array_buffer_allocator->Allocate(length);
-  v8::Handle<v8::ArrayBuffer> value =
-      v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), data, length);
-  new ArrayBuffer(value, data, length);
+  return NewArrayBuffer(data, length);
+}
+
+void* Variant::AllocateArrayBufferData(size_t length) {
+  return array_buffer_allocator->AllocateUninitialized(length);
+}
+
+void Variant::FreeArrayBufferData(void* data, size_t length) {
+  array_buffer_allocator->Free(data, length);
+}
+
+Variant::ArrayBufferStatistics Variant::GetArrayBufferStatistics() {
+  return array_buffer_allocator->GetStatistics();
+}
+
+Object Variant::MakeExternalArrayBuffer(void* data, size_t length,
+                                       ReleaseCallback release) {
+  v8::Local<v8::ArrayBuffer> value = v8::ArrayBuffer::New(
+      v8::Isolate::GetCurrent(), data, length,
+      v8::ArrayBufferCreationMode::kExternalized);
+  new ExternalArrayBuffer(value, data, length, release);
   return value;
 }
 
+Object Variant::AdoptArrayBuffer(void* data, size_t length) {
+  return NewArrayBuffer(data, length);
+}
+
 void* Variant::ExtractArrayBufferData() const {
   v8::Handle<v8::ArrayBuffer> value;
   size_t offset;
@@ -337,7 +484,7 @@ void* Variant::ExtractArrayBufferData() const {
     throw TypeError("Object is not ArrayBuffer or ArrayBufferView");
   }
 
-  return static_cast<char*>(ArrayBuffer::Get(value)->data()) + offset;
+  return static_cast<char*>(value->GetContents().Data()) + offset;
 }
 
 size_t Variant::ExtractArrayBufferLength() const {
@@ -349,6 +496,24 @@ size_t Variant::ExtractArrayBufferLength() const {
     throw TypeError("Object is not ArrayBuffer or ArrayBufferView");
 }
 
+Object Variant::ExtractArrayBuffer() const {
+  if (handle_->IsArrayBuffer())
+    return handle_.As<v8::Object>();
+  else if (handle_->IsArrayBufferView())
+    return v8::ArrayBufferView::Cast(*handle_)->Buffer();
+  else
+    throw TypeError("Object is not ArrayBuffer or ArrayBufferView");
+}
+
+size_t Variant::ExtractArrayBufferOffset() const {
+  if (handle_->IsArrayBuffer())
+    return 0;
+  else if (handle_->IsArrayBufferView())
+    return v8::ArrayBufferView::Cast(*handle_)->ByteOffset();
+  else
+    throw TypeError("Object is not ArrayBuffer or ArrayBufferView");
+}
+
 namespace {
 
 template<typename V8Type, unsigned ElementSize>
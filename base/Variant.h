@@ -22,6 +22,8 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 template <typename T> class Optional;
 
@@ -82,8 +84,37 @@ class Variant {
 
   static base::Object MakeArrayBuffer(const void* data, size_t length);
   static base::Object MakeArrayBuffer(size_t length);
+
+  static void* AllocateArrayBufferData(size_t length);
+  static void FreeArrayBufferData(void* data, size_t length);
+  static base::Object AdoptArrayBuffer(void* data, size_t length);
+  /**< Create an ArrayBuffer that takes ownership of 'data', which must have
+       been allocated by AllocateArrayBufferData() and be at least 'length'
+       bytes long. */
+
+  typedef void (*ReleaseCallback)(void* data, size_t length);
+
+  static base::Object MakeExternalArrayBuffer(void* data, size_t length,
+                                              ReleaseCallback release);
+  /**< Create an ArrayBuffer over memory not allocated by the ArrayBuffer
+       allocator, such as a file mapping.  'release' is called when the
+       buffer has been garbage collected.  The memory is reported to V8 as
+       externally allocated meanwhile. */
+
+  struct ArrayBufferStatistics {
+    size_t live_bytes;
+    size_t live_buffers;
+    size_t pooled_bytes;
+    std::vector<std::pair<size_t, size_t>> allocations;
+    /**< Number of allocations made so far per pooled size class. */
+    size_t large_allocations;
+  };
+
+  static ArrayBufferStatistics GetArrayBufferStatistics();
   void* ExtractArrayBufferData() const;
   size_t ExtractArrayBufferLength() const;
+  base::Object ExtractArrayBuffer() const;
+  size_t ExtractArrayBufferOffset() const;
 
   static base::Object MakeUint8Array(Variant array_buffer,
                                      size_t byte_offset = 0,
@@ -32,6 +32,8 @@
 #include "api/GC.h"
 #include "api/Runtime.h"
 #include "modules/Modules.h"
+#include "modules/BuiltIn.h"
+#include "modules/builtin/EventLoop.h"
 #include "modules/builtin/Module.h"
 #include "jsshell/ArgumentsParser.h"
 #include "utilities/Anchor.h"
@@ -130,6 +132,10 @@ int Main(const std::vector<std::string>& argv,
   v8::Isolate* isolate = v8::Isolate::New(create_params);
   v8::Isolate::Scope isolate_scope(isolate);
 
+  /* Microtasks (promise reactions) run after each script and after each
+     event loop callback; see modules::builtin::EventLoop. */
+  isolate->SetMicrotasksPolicy(v8::MicrotasksPolicy::kExplicit);
+
   v8::V8::SetCaptureStackTraceForUncaughtExceptions(true);
 
   base::Initialize();
@@ -165,6 +171,9 @@ int Main(const std::vector<std::string>& argv,
       else
         modules::builtin::Module::Load(root, iter->value());
 
+      if (!try_catch.HasCaught())
+        isolate->RunMicrotasks();
+
       if (try_catch.HasCaught()) {
         PrintException(try_catch);
         return EXIT_FAILURE;
@@ -172,6 +181,24 @@ int Main(const std::vector<std::string>& argv,
     }
   }
 
+  /* Run timers and watches set up by the scripts until there are none
+     left. */
+  {
+    v8::TryCatch try_catch;
+
+    try {
+      modules::BuiltIn::FromContext()->event_loop()->Run();
+    } catch (base::NestedException&) {
+    } catch (base::Error& error) {
+      error.Raise();
+    }
+
+    if (try_catch.HasCaught()) {
+      PrintException(try_catch);
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
 
@@ -21,37 +21,58 @@
 #include "modules/BuiltIn.h"
 
 #include <stdio.h>
+#include <unistd.h>
+#include <sys/epoll.h>
 
 #include "api/Runtime.h"
 #include "modules/Modules.h"
 #include "modules/builtin/Bytes.h"
+#include "modules/builtin/BytesBuilder.h"
+#include "modules/builtin/EventLoop.h"
 #include "modules/builtin/Module.h"
 #include "utilities/Formatter.h"
 #include "utilities/FileDescriptor.h"
+#include "utilities/ThreadPool.h"
 
 namespace modules {
 
 BuiltIn::BuiltIn()
     : api::Module(kBuiltIn, "__builtin__")
     , bytes_(new builtin::Bytes)
-    , module_(new builtin::Module) {
+    , bytes_builder_(new builtin::BytesBuilder)
+    , module_(new builtin::Module)
+    , event_loop_(new builtin::EventLoop)
+    , buffered_output_(false) {
 }
 
 BuiltIn::~BuiltIn() {
   delete bytes_;
+  delete bytes_builder_;
   delete module_;
+  delete event_loop_;
 }
 
 void BuiltIn::ExtendObject(base::Object target) {
   AddFunction(target, "format", &format);
   AddFunction(target, "write", &write);
   AddFunction(target, "writeln", &writeln);
+  AddFunction(target, "setBufferedOutput", &setBufferedOutput);
+  AddFunction(target, "flush", &flush);
   AddFunction(target, "read", &read);
   AddFunction(target, "readln", &readln);
   AddFunction(target, "scoped", &scoped);
   AddFunction(target, "exit", &exit);
+  AddFunction(target, "setTimeout", &setTimeout);
+  AddFunction(target, "setInterval", &setInterval);
+  AddFunction(target, "clearTimeout", &clearTimeout);
+  AddFunction(target, "clearInterval", &clearTimeout);
+  AddFunction(target, "watch", &watch);
+  AddFunction(target, "unwatch", &unwatch);
+  AddFunction(target, "runEventLoop", &runEventLoop);
+  AddFunction(target, "threadPoolStatistics", &threadPoolStatistics);
 
   bytes_->AddTo(target);
+  bytes_builder_->AddTo(target);
   module_->AddTo(target);
 }
 
@@ -67,7 +88,8 @@ void BuiltIn::write(BuiltIn* module, std::string format,
   else
     ::fputs(utilities::Formatter().Format(format, rest).c_str(), stdout);
 
-  ::fflush(stdout);
+  if (!module->buffered_output_)
+    ::fflush(stdout);
 }
 
 void BuiltIn::writeln(BuiltIn* module, Optional<std::string> format,
@@ -76,6 +98,21 @@ void BuiltIn::writeln(BuiltIn* module, Optional<std::string> format,
     write(module, format.value(), rest);
 
   ::fputc('\n', stdout);
+
+  if (!module->buffered_output_)
+    ::fflush(stdout);
+}
+
+void BuiltIn::setBufferedOutput(BuiltIn* module, bool enabled) {
+  /* Output to a terminal is always flushed straight away, so that
+     interactive output isn't delayed. */
+  module->buffered_output_ = enabled && !::isatty(STDOUT_FILENO);
+
+  if (!module->buffered_output_)
+    ::fflush(stdout);
+}
+
+void BuiltIn::flush(BuiltIn* module) {
   ::fflush(stdout);
 }
 
@@ -138,6 +175,106 @@ void BuiltIn::exit(BuiltIn*, int status) {
   ::exit(status);
 }
 
+namespace {
+
+class CallbackHandler : public builtin::EventLoop::Handler {
+ public:
+  CallbackHandler(base::Function callback,
+                  const std::vector<base::Variant>& arguments)
+      : callback_(callback.object())
+      , arguments_(base::Array::FromVector(arguments)) {
+  }
+
+  virtual bool Ready(std::uint32_t events) override {
+    base::Object arguments_array(arguments_.GetObject());
+    std::vector<base::Variant> arguments;
+    unsigned length = arguments_array.Get("length").AsInt32();
+
+    for (unsigned index = 0; index < length; ++index)
+      arguments.push_back(arguments_array.Get(index));
+
+    if (events != 0) {
+      base::Object ready(base::Object::Create());
+      ready.Put("read", base::Variant::Boolean(
+          (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0));
+      ready.Put("write", base::Variant::Boolean(
+          (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0));
+      arguments.push_back(ready);
+    }
+
+    base::Function(callback_.GetObject()).Call(base::Object(), arguments);
+    return true;
+  }
+
+ private:
+  base::Object::Persistent callback_;
+  base::Object::Persistent arguments_;
+};
+
+}
+
+unsigned BuiltIn::setTimeout(BuiltIn* module, base::Function callback,
+                             Optional<double> delay,
+                             const std::vector<base::Variant>& rest) {
+  return module->event_loop_->AddTimer(
+      delay.value(0), false, new CallbackHandler(callback, rest));
+}
+
+unsigned BuiltIn::setInterval(BuiltIn* module, base::Function callback,
+                              Optional<double> delay,
+                              const std::vector<base::Variant>& rest) {
+  return module->event_loop_->AddTimer(
+      delay.value(0), true, new CallbackHandler(callback, rest));
+}
+
+void BuiltIn::clearTimeout(BuiltIn* module, Optional<unsigned> id) {
+  if (id.specified())
+    module->event_loop_->RemoveTimer(id.value());
+}
+
+unsigned BuiltIn::watch(BuiltIn* module, utilities::FileDescriptor fd,
+                        std::string mode, base::Function callback) {
+  std::uint32_t events;
+
+  if (mode == "read")
+    events = EPOLLIN;
+  else if (mode == "write")
+    events = EPOLLOUT;
+  else if (mode == "both")
+    events = EPOLLIN | EPOLLOUT;
+  else
+    throw base::TypeError("invalid mode argument: " + mode);
+
+  return module->event_loop_->AddWatch(
+      fd, events, new CallbackHandler(callback, std::vector<base::Variant>()));
+}
+
+void BuiltIn::unwatch(BuiltIn* module, unsigned id) {
+  module->event_loop_->RemoveWatch(id);
+}
+
+void BuiltIn::runEventLoop(BuiltIn* module) {
+  module->event_loop_->Run();
+}
+
+base::Object BuiltIn::threadPoolStatistics(BuiltIn* module) {
+  utilities::ThreadPool::Statistics statistics(
+      utilities::ThreadPool::Shared().GetStatistics());
+  base::Object result(base::Object::Create());
+
+  result.Put("threads", base::Variant::UInt32(statistics.threads));
+  result.Put("queued", base::Variant::Number(statistics.queued));
+  result.Put("running", base::Variant::Number(statistics.running));
+  result.Put("completed", base::Variant::Number(statistics.completed));
+  result.Put("stolen", base::Variant::Number(statistics.stolen));
+  result.Put("totalWait", base::Variant::Number(statistics.total_wait));
+  result.Put("maxWait", base::Variant::Number(statistics.max_wait));
+  result.Put("totalRun", base::Variant::Number(statistics.total_run));
+  result.Put("maxRun", base::Variant::Number(statistics.max_run));
+
+  return result;
+}
+
 BuiltIn* BuiltIn::FromContext(v8::Handle<v8::Context> context) {
   return api::Module::FromContext<BuiltIn>(kBuiltIn, context);
 }
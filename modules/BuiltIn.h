@@ -21,11 +21,14 @@
 #define MODULES_BUILTIN_H
 
 #include "api/Module.h"
+#include "utilities/FileDescriptor.h"
 
 namespace modules {
 
 namespace builtin {
 class Bytes;
+class BytesBuilder;
+class EventLoop;
 class Module;
 }
 
@@ -37,7 +40,9 @@ class BuiltIn : public api::Module {
   virtual void ExtendObject(base::Object target) override;
 
   builtin::Bytes* bytes() { return bytes_; }
+  builtin::BytesBuilder* bytes_builder() { return bytes_builder_; }
   builtin::Module* module() { return module_; }
+  builtin::EventLoop* event_loop() { return event_loop_; }
 
   static std::string format(BuiltIn* module, std::string format,
                             const std::vector<base::Variant>& rest);
@@ -48,6 +53,9 @@ class BuiltIn : public api::Module {
   static void writeln(BuiltIn* module, Optional<std::string> format,
                       const std::vector<base::Variant>& rest);
 
+  static void setBufferedOutput(BuiltIn* module, bool enabled);
+  static void flush(BuiltIn* module);
+
   static std::string read(BuiltIn* module);
   static std::string readln(BuiltIn* module);
 
@@ -57,12 +65,31 @@ class BuiltIn : public api::Module {
 
   static void exit(BuiltIn*, int status);
 
+  static unsigned setTimeout(BuiltIn* module, base::Function callback,
+                             Optional<double> delay,
+                             const std::vector<base::Variant>& rest);
+  static unsigned setInterval(BuiltIn* module, base::Function callback,
+                              Optional<double> delay,
+                              const std::vector<base::Variant>& rest);
+  static void clearTimeout(BuiltIn* module, Optional<unsigned> id);
+  static unsigned watch(BuiltIn* module, utilities::FileDescriptor fd,
+                        std::string mode, base::Function callback);
+  static void unwatch(BuiltIn* module, unsigned id);
+  static void runEventLoop(BuiltIn* module);
+  static base::Object threadPoolStatistics(BuiltIn* module);
+
   static BuiltIn* FromContext(
       v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
 
  private:
   builtin::Bytes* bytes_;
+  builtin::BytesBuilder* bytes_builder_;
   builtin::Module* module_;
+  builtin::EventLoop* event_loop_;
+
+  /* True if write() and writeln() leave flushing stdout to the C library,
+     which then happens when its buffer fills up and at exit. */
+  bool buffered_output_;
 };
 
 }
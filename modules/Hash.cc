@@ -0,0 +1,134 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "modules/Hash.h"
+
+#include <memory>
+
+#include "api/Runtime.h"
+#include "modules/Modules.h"
+#include "modules/builtin/EventLoop.h"
+#include "modules/hash/Algorithm.h"
+#include "modules/hash/Hasher.h"
+#include "utilities/Encoding.h"
+
+namespace modules {
+
+Hash::Hash(const Features& features)
+    : api::Module(kHash, "Hash")
+    , hasher_(new hash::Hasher) {
+}
+
+Hash::~Hash() {
+  delete hasher_;
+}
+
+void Hash::ExtendObject(base::Object target) {
+  hasher_->AddTo(target);
+
+  AddFunction(target, "sha1", sha1);
+  AddFunction(target, "sha256", sha256);
+  AddFunction(target, "xxh64", xxh64);
+  AddFunction(target, "gitObjectId", gitObjectId);
+  AddFunction(target, "digestAsync", digestAsync);
+}
+
+void Hash::ExtendRuntime(api::Runtime& runtime) {
+  AddTo(runtime.GetGlobalObject());
+  ExtendObject(GetObject());
+}
+
+Hash* Hash::FromContext(v8::Handle<v8::Context> context) {
+  return api::Module::FromContext<Hash>(kHash, context);
+}
+
+namespace {
+
+builtin::Bytes::Value Digest(hash::Algorithm* algorithm_in,
+                             builtin::Bytes::Value data) {
+  std::unique_ptr<hash::Algorithm> algorithm(algorithm_in);
+  algorithm->Update(data.data(), data.length());
+  return builtin::Bytes::FromContext()->New(algorithm->Digest());
+}
+
+}
+
+builtin::Bytes::Value Hash::sha1(Hash*, builtin::Bytes::Value data) {
+  return Digest(new hash::SHA1, data);
+}
+
+builtin::Bytes::Value Hash::sha256(Hash*, builtin::Bytes::Value data) {
+  return Digest(new hash::SHA256, data);
+}
+
+builtin::Bytes::Value Hash::xxh64(Hash*, builtin::Bytes::Value data,
+                                  Optional<std::int64_t> seed) {
+  return Digest(new hash::XXH64(seed.value(0)), data);
+}
+
+std::string Hash::gitObjectId(Hash*, builtin::Bytes::Value data,
+                              Optional<std::string> type) {
+  /* Same as 'git hash-object -t <type>': SHA-1 over "<type> <size>\0" followed
+     by the contents. */
+  std::string header(type.value("blob") + " " +
+                     std::to_string(data.length()));
+  hash::SHA1 algorithm;
+
+  algorithm.Update(header.c_str(), header.length() + 1);
+  algorithm.Update(data.data(), data.length());
+
+  std::string digest(algorithm.Digest());
+  std::string result(2 * digest.length(), '\0');
+  utilities::Encoding::EncodeHex(digest.data(), digest.length(), &result[0]);
+  return result;
+}
+
+base::Object Hash::digestAsync(Hash*, std::string name,
+                               builtin::Bytes::Value data,
+                               utilities::Options options) {
+  struct State {
+    std::unique_ptr<hash::Algorithm> algorithm;
+    const void* data;
+    size_t length;
+    std::string digest;
+  };
+
+  std::shared_ptr<State> state(new State);
+
+  state->algorithm.reset(hash::Algorithm::Create(
+      name, static_cast<std::uint64_t>(options.GetNumber("seed", 0))));
+
+  if (!state->algorithm)
+    throw base::TypeError("unsupported algorithm: " + name);
+
+  state->data = data.data();
+  state->length = data.length();
+
+  return builtin::EventLoop::FromContext()->RunInBackground(
+      [state]() {
+        state->algorithm->Update(state->data, state->length);
+        state->digest = state->algorithm->Digest();
+      },
+      [state](builtin::EventLoop::Promise& promise) {
+        promise.Resolve(builtin::Bytes::FromContext()->New(state->digest));
+      },
+      base::Variant(data).AsObject());
+}
+
+}
@@ -0,0 +1,68 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef MODULES_HASH_H
+#define MODULES_HASH_H
+
+#include "api/Module.h"
+#include "modules/builtin/Bytes.h"
+#include "utilities/Options.h"
+
+namespace api {
+class Runtime;
+}
+
+namespace modules {
+
+class Features;
+
+namespace hash {
+class Hasher;
+}
+
+class Hash : public api::Module {
+ public:
+  Hash(const Features& features);
+  ~Hash();
+
+  virtual void ExtendObject(base::Object target) override;
+  virtual void ExtendRuntime(api::Runtime& runtime) override;
+
+  hash::Hasher* hasher() { return hasher_; }
+
+  static Hash* FromContext(
+      v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
+
+ private:
+  hash::Hasher* hasher_;
+
+  static builtin::Bytes::Value sha1(Hash*, builtin::Bytes::Value data);
+  static builtin::Bytes::Value sha256(Hash*, builtin::Bytes::Value data);
+  static builtin::Bytes::Value xxh64(Hash*, builtin::Bytes::Value data,
+                                     Optional<std::int64_t> seed);
+  static std::string gitObjectId(Hash*, builtin::Bytes::Value data,
+                                 Optional<std::string> type);
+  static base::Object digestAsync(Hash*, std::string name,
+                                  builtin::Bytes::Value data,
+                                  utilities::Options options);
+};
+
+}
+
+#endif // MODULES_HASH_H
@@ -20,16 +20,25 @@
 #include "Base.h"
 #include "modules/IO.h"
 
+#include <unistd.h>
+
+#include <limits>
+
 #include "api/Runtime.h"
 #include "modules/Modules.h"
+#include "modules/builtin/Bytes.h"
+#include "modules/io/Batch.h"
 #include "modules/io/File.h"
+#include "modules/io/IOError.h"
 #include "modules/io/MemoryFile.h"
 #include "modules/io/Socket.h"
 #include "modules/io/Poll.h"
 #include "modules/io/Stat.h"
 #include "modules/io/Pipe.h"
 #include "modules/io/Buffered.h"
+#include "modules/io/BufferedWriter.h"
 #include "modules/io/Path.h"
+#include "modules/io/Watcher.h"
 
 namespace modules {
 
@@ -43,7 +52,9 @@ IO::IO(const Features& features)
     , stat_(new io::Stat)
     , pipe_(new io::Pipe)
     , buffered_(new io::Buffered)
-    , path_(new io::Path) {
+    , buffered_writer_(new io::BufferedWriter)
+    , path_(new io::Path)
+    , watcher_(new io::Watcher) {
 }
 
 IO::~IO() {
@@ -55,7 +66,9 @@ IO::~IO() {
   delete stat_;
   delete pipe_;
   delete buffered_;
+  delete buffered_writer_;
   delete path_;
+  delete watcher_;
 }
 
 void IO::ExtendObject(base::Object target) {
@@ -67,7 +80,12 @@ void IO::ExtendObject(base::Object target) {
   stat_->AddTo(target);
   pipe_->AddTo(target);
   buffered_->AddTo(target);
+  buffered_writer_->AddTo(target);
   path_->AddTo(target);
+  watcher_->AddTo(target);
+
+  AddFunction(target, "splice", &splice);
+  AddFunction(target, "batch", &batch);
 }
 
 void IO::ExtendRuntime(api::Runtime& runtime) {
@@ -75,6 +93,126 @@ void IO::ExtendRuntime(api::Runtime& runtime) {
   ExtendObject(GetObject());
 }
 
+std::int64_t IO::splice(IO*, utilities::FileDescriptor from,
+                        utilities::FileDescriptor to,
+                        Optional<std::int64_t> nbytes_arg) {
+  std::uint64_t nbytes = std::numeric_limits<std::uint64_t>::max();
+
+  if (nbytes_arg.specified()) {
+    if (nbytes_arg.value() < 0)
+      throw base::RangeError("invalid argument; must be non-negative");
+    nbytes = nbytes_arg.value();
+  }
+
+  try {
+    return utilities::FileDescriptor::Transfer(from, to, nbytes);
+  } catch (utilities::FileDescriptor::Error& error) {
+    throw io::IOError("splice() failed", error.errnum);
+  }
+}
+
+std::vector<base::Variant> IO::batch(
+    IO* module, std::vector<utilities::Options> operations_arg,
+    utilities::Options options) {
+  std::string backend_arg(options.GetString("backend", "auto"));
+  io::Batch::Backend backend;
+
+  if (backend_arg == "auto")
+    backend = io::Batch::kAutomatic;
+  else if (backend_arg == "io_uring")
+    backend = io::Batch::kRing;
+  else if (backend_arg == "threads")
+    backend = io::Batch::kThreads;
+  else
+    throw base::TypeError("invalid backend option: " + backend_arg);
+
+  if (backend == io::Batch::kRing && !io::Batch::IsRingSupported())
+    throw io::IOError("io_uring not supported", ENOSYS);
+
+  unsigned threads = options.GetUInt32(
+      "threads", std::max<long>(::sysconf(_SC_NPROCESSORS_ONLN), 1));
+
+  std::vector<io::Batch::Operation> operations;
+  /* Keeps the data to write alive while the operations are performed. */
+  std::vector<builtin::Bytes::Value> inputs;
+
+  operations.reserve(operations_arg.size());
+
+  for (auto iter(operations_arg.begin()); iter != operations_arg.end();
+       ++iter) {
+    if (!iter->Has("path"))
+      throw base::TypeError("invalid operation: missing path");
+
+    std::string op(iter->GetString("op"));
+    std::string path(iter->GetString("path"));
+
+    if (op == "read") {
+      operations.emplace_back(io::Batch::Operation::kRead, path);
+    } else if (op == "stat") {
+      operations.emplace_back(io::Batch::Operation::kStat, path);
+    } else if (op == "lstat") {
+      operations.emplace_back(io::Batch::Operation::kLStat, path);
+    } else if (op == "write") {
+      if (!iter->Has("data"))
+        throw base::TypeError("invalid write operation: missing data");
+      inputs.push_back(base::AsValue<builtin::Bytes::Value>(
+          iter->Get("data").handle()));
+      operations.emplace_back(io::Batch::Operation::kWrite, path);
+      operations.back().input = inputs.back().data();
+      operations.back().input_length = inputs.back().length();
+    } else {
+      throw base::TypeError("invalid operation: " + op);
+    }
+  }
+
+  io::Batch::Run(operations, backend, threads);
+
+  /* Even failed writes may have created or truncated the file. */
+  io::File* file = io::File::FromContext();
+
+  for (auto iter(operations.begin()); iter != operations.end(); ++iter)
+    if (iter->type == io::Batch::Operation::kWrite)
+      file->InvalidateStat(iter->path);
+
+  builtin::Bytes* bytes = builtin::Bytes::FromContext();
+  std::vector<base::Variant> results;
+
+  for (auto iter(operations.begin()); iter != operations.end(); ++iter) {
+    if (iter->error) {
+      io::IOError error(iter->failed_call + std::string(" failed"),
+                        iter->error);
+      error << " (" << iter->path << ")";
+      results.push_back(error.ToObject());
+      continue;
+    }
+
+    switch (iter->type) {
+      case io::Batch::Operation::kRead:
+        /* Don't keep a mostly unused buffer alive; copy short results
+           instead. */
+        if (iter->length < iter->capacity / 2) {
+          results.push_back(bytes->New(iter->data, iter->length));
+          base::Variant::FreeArrayBufferData(iter->data, iter->capacity);
+        } else {
+          results.push_back(bytes->Adopt(iter->data, iter->length));
+        }
+        break;
+
+      case io::Batch::Operation::kStat:
+      case io::Batch::Operation::kLStat:
+        results.push_back(
+            base::AsResult(io::Stat::FromContext()->New(iter->status)));
+        break;
+
+      case io::Batch::Operation::kWrite:
+        results.push_back(base::Variant::Undefined());
+        break;
+    }
+  }
+
+  return results;
+}
+
 IO* IO::FromContext(v8::Handle<v8::Context> context) {
   return api::Module::FromContext<IO>(kIO, context);
 }
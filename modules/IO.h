@@ -21,6 +21,8 @@
 #define MODULES_IO_H
 
 #include "api/Module.h"
+#include "utilities/FileDescriptor.h"
+#include "utilities/Options.h"
 
 namespace modules {
 
@@ -35,7 +37,9 @@ class Poll;
 class Stat;
 class Pipe;
 class Buffered;
+class BufferedWriter;
 class Path;
+class Watcher;
 }
 
 class IO : public api::Module {
@@ -54,12 +58,21 @@ class IO : public api::Module {
   io::Stat* stat() { return stat_; }
   io::Pipe* pipe() { return pipe_; }
   io::Buffered* buffered() { return buffered_; }
+  io::BufferedWriter* buffered_writer() { return buffered_writer_; }
   io::Path* path() { return path_; }
+  io::Watcher* watcher() { return watcher_; }
 
   static IO* FromContext(
       v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
 
  private:
+  static std::int64_t splice(IO*, utilities::FileDescriptor from,
+                             utilities::FileDescriptor to,
+                             Optional<std::int64_t> nbytes);
+  static std::vector<base::Variant> batch(
+      IO*, std::vector<utilities::Options> operations,
+      utilities::Options options);
+
   io::File* file_;
   io::MemoryFile* memory_file_;
   io::Socket* socket_;
@@ -68,7 +81,9 @@ class IO : public api::Module {
   io::Stat* stat_;
   io::Pipe* pipe_;
   io::Buffered* buffered_;
+  io::BufferedWriter* buffered_writer_;
   io::Path* path_;
+  io::Watcher* watcher_;
 };
 
 }
@@ -31,6 +31,7 @@ enum {
   kBuiltIn,
   kIO,
   kOS,
+  kHash,
 #if LIBCURL_SUPPORT
   kURL,
 #endif
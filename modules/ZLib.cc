@@ -22,9 +22,19 @@
 #include "Base.h"
 #include "modules/ZLib.h"
 
+#include <unistd.h>
+#include <zlib.h>
+
+#include <limits>
+#include <memory>
+
 #include "api/Runtime.h"
 #include "modules/Modules.h"
+#include "modules/builtin/EventLoop.h"
+#include "modules/zlib/Error.h"
+#include "modules/zlib/Parallel.h"
 #include "modules/zlib/Stream.h"
+#include "utilities/Checksum.h"
 
 namespace modules {
 
@@ -42,6 +52,11 @@ void ZLib::ExtendObject(base::Object target) {
 
   AddFunction(target, "deflate", deflate);
   AddFunction(target, "inflate", inflate);
+  AddFunction(target, "deflateAsync", deflateAsync);
+  AddFunction(target, "inflateAsync", inflateAsync);
+  AddFunction(target, "crc32", crc32);
+  AddFunction(target, "adler32", adler32);
+  AddFunction(target, "crc32c", crc32c);
 }
 
 void ZLib::ExtendRuntime(api::Runtime& runtime) {
@@ -53,20 +68,129 @@ ZLib* ZLib::FromContext(v8::Handle<v8::Context> context) {
   return api::Module::FromContext<ZLib>(kZLib, context);
 }
 
-builtin::Bytes::Instance* ZLib::deflate(ZLib*, builtin::Bytes::Instance* data,
-                                        Optional<int> level_opt) {
-  int level;
+builtin::Bytes::Value ZLib::deflate(ZLib*, builtin::Bytes::Value data,
+                                    Optional<base::Variant> options_opt) {
+  base::Variant options(options_opt.value(base::Variant::Undefined()));
+
+  /* The second argument used to be just the compression level, so a plain
+     number is still accepted as such. */
+  if (options.IsNumber()) {
+    base::Object object(base::Object::Create());
+    object.Put("level", options);
+    options = object;
+  }
+
+  utilities::Options parsed(base::AsValue<utilities::Options>(options));
+  zlib::Stream::Parameters parameters(
+      zlib::Stream::ParseOptions(false, parsed));
+
+  unsigned threads = parsed.GetUInt32("threads", 1);
+  if (threads == 0)
+    threads = ::sysconf(_SC_NPROCESSORS_ONLN);
+
+  size_t block_size = parsed.GetUInt32("blockSize", 128 * 1024);
+  if (block_size < 32 * 1024)
+    throw base::RangeError("Invalid argument: blockSize >= 32768 required");
+
+  /* A preset dictionary only applies to the start of the stream, which the
+     block splitting can't express, so such input is always deflated
+     serially. */
+  if (threads > 1 && data.length() > block_size &&
+      parameters.dictionary.empty())
+    return zlib::Parallel::Deflate(data, parameters, threads, block_size);
+
+  return zlib::Stream::Deflate(data, parameters);
+}
+
+builtin::Bytes::Value ZLib::inflate(ZLib*, builtin::Bytes::Value data,
+                                    utilities::Options options) {
+  return zlib::Stream::Inflate(data, zlib::Stream::ParseOptions(true, options));
+}
+
+namespace {
+
+base::Object ProcessAsync(builtin::Bytes::Value data,
+                          const zlib::Stream::Parameters& parameters) {
+  struct State {
+    State(const zlib::Stream::Parameters& parameters)
+        : parameters(parameters) {
+    }
+
+    zlib::Stream::Parameters parameters;
+    const void* data;
+    size_t length;
+    std::string output;
+    std::string error;
+  };
+
+  std::shared_ptr<State> state(new State(parameters));
+
+  state->data = data.data();
+  state->length = data.length();
+
+  return builtin::EventLoop::FromContext()->RunInBackground(
+      [state]() {
+        try {
+          state->output = zlib::Stream::Process(
+              state->parameters, state->data, state->length);
+        } catch (base::Error& error) {
+          state->error = error.message();
+        }
+      },
+      [state](builtin::EventLoop::Promise& promise) {
+        if (!state->error.empty())
+          throw zlib::Error(state->error);
+        promise.Resolve(builtin::Bytes::FromContext()->New(state->output));
+      },
+      base::Variant(data).AsObject());
+}
+
+}
+
+base::Object ZLib::deflateAsync(ZLib*, builtin::Bytes::Value data,
+                                utilities::Options options) {
+  return ProcessAsync(data, zlib::Stream::ParseOptions(false, options));
+}
 
-  if (level_opt.specified())
-    level = level_opt.value();
-  else
-    level = -1;
+base::Object ZLib::inflateAsync(ZLib*, builtin::Bytes::Value data,
+                                utilities::Options options) {
+  return ProcessAsync(data, zlib::Stream::ParseOptions(true, options));
+}
+
+namespace {
+
+/* zlib's length arguments are 'uInt', so feed it large buffers piecewise. */
+template <uLong (*Function)(uLong, const Bytef*, uInt)>
+unsigned Checksum(uLong check, builtin::Bytes::Value data) {
+  const Bytef* bytes = static_cast<const Bytef*>(data.data());
+  size_t length = data.length();
+
+  do {
+    uInt piece = std::min<size_t>(length, std::numeric_limits<uInt>::max());
+    check = Function(check, bytes, piece);
+    bytes += piece;
+    length -= piece;
+  } while (length != 0);
+
+  return check;
+}
+
+}
+
+unsigned ZLib::crc32(ZLib*, builtin::Bytes::Value data,
+                     Optional<unsigned> seed) {
+  return Checksum<::crc32>(seed.value(0), data);
+}
 
-  return zlib::Stream::Deflate(data, level);
+unsigned ZLib::adler32(ZLib*, builtin::Bytes::Value data,
+                       Optional<unsigned> seed) {
+  return Checksum<::adler32>(seed.value(1), data);
 }
 
-builtin::Bytes::Instance* ZLib::inflate(ZLib*, builtin::Bytes::Instance* data) {
-  return zlib::Stream::Inflate(data);
+unsigned ZLib::crc32c(ZLib*, builtin::Bytes::Value data,
+                      Optional<unsigned> seed) {
+  return utilities::Checksum::CRC32C(seed.value(0), data.data(),
+                                     data.length());
 }
 
 }
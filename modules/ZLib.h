@@ -24,6 +24,7 @@
 
 #include "api/Module.h"
 #include "modules/builtin/Bytes.h"
+#include "utilities/Options.h"
 
 namespace api {
 class Runtime;
@@ -53,10 +54,21 @@ class ZLib : public api::Module {
  private:
   zlib::Stream* stream_;
 
-  static builtin::Bytes::Instance* deflate(
-      ZLib*, builtin::Bytes::Instance* data, Optional<int> level);
-  static builtin::Bytes::Instance* inflate(
-      ZLib*, builtin::Bytes::Instance* data);
+  static builtin::Bytes::Value deflate(
+      ZLib*, builtin::Bytes::Value data, Optional<base::Variant> options);
+  static builtin::Bytes::Value inflate(
+      ZLib*, builtin::Bytes::Value data, utilities::Options options);
+  static base::Object deflateAsync(
+      ZLib*, builtin::Bytes::Value data, utilities::Options options);
+  static base::Object inflateAsync(
+      ZLib*, builtin::Bytes::Value data, utilities::Options options);
+
+  static unsigned crc32(ZLib*, builtin::Bytes::Value data,
+                        Optional<unsigned> seed);
+  static unsigned adler32(ZLib*, builtin::Bytes::Value data,
+                          Optional<unsigned> seed);
+  static unsigned crc32c(ZLib*, builtin::Bytes::Value data,
+                         Optional<unsigned> seed);
 };
 
 }
@@ -20,10 +20,14 @@
 #include "Base.h"
 #include "modules/builtin/Bytes.h"
 
+#include <string.h>
+
 #include <memory>
 #include <algorithm>
+#include <limits>
 
 #include "modules/BuiltIn.h"
+#include "utilities/Encoding.h"
 
 namespace modules {
 namespace builtin {
@@ -32,10 +36,19 @@ Bytes::Bytes()
     : Class("Bytes", &constructor) {
   AddGenericMethod<Bytes>("toString", &decode);
   AddGenericMethod<Bytes>("decode", &decode);
+  AddGenericMethod<Bytes>("isValidUTF8", &isValidUTF8);
+  AddGenericMethod<Bytes>("indexOf", &indexOf);
+  AddGenericMethod<Bytes>("lastIndexOf", &lastIndexOf);
+  AddGenericMethod<Bytes>("count", &count);
+  AddGenericMethod<Bytes>("split", &split);
+  AddGenericMethod<Bytes>("lines", &lines);
   AddGenericMethod<Bytes>("slice", &slice);
+  AddGenericMethod<Bytes>("copy", &copy);
   AddGenericMethod<Bytes>("concat", &concat);
   AddGenericMethod<Bytes>("toJSON", &toJSON);
   AddClassFunction<Bytes>("encode", &encode);
+  AddClassFunction<Bytes>("concat", &concatAll);
+  AddClassFunction<Bytes>("allocatorStatistics", &allocatorStatistics);
   Inherit(base::Variant::MakeUint8Array(
       base::Variant::MakeArrayBuffer(0)).GetPrototype());
 }
@@ -69,6 +82,26 @@ Bytes::Value Bytes::New(size_t length) {
   return result;
 }
 
+Bytes::Value Bytes::NewUninitialized(size_t length) {
+  return Adopt(base::Variant::AllocateArrayBufferData(length), length);
+}
+
+Bytes::Value Bytes::Adopt(void* data, size_t length) {
+  base::Variant result(base::Variant::MakeUint8Array(
+      base::Variant::AdoptArrayBuffer(data, length)));
+  result.AsObject().SetPrototype(GetPrototype());
+  return result;
+}
+
+Bytes::Value Bytes::View(Value source, size_t offset, size_t length) {
+  base::Variant variant(source);
+  base::Variant result(base::Variant::MakeUint8Array(
+      variant.ExtractArrayBuffer(),
+      variant.ExtractArrayBufferOffset() + offset, length));
+  result.AsObject().SetPrototype(GetPrototype());
+  return result;
+}
+
 Bytes* Bytes::FromContext(v8::Handle<v8::Context> context) {
   return BuiltIn::FromContext(context)->bytes();
 }
@@ -78,37 +111,312 @@ Bytes::Value Bytes::constructor(
   return bytes->New(length);
 }
 
-std::string Bytes::decode(Value instance, Optional<std::string> encoding) {
-  if (!encoding.specified() ||
-      encoding.value() == "ascii" ||
-      encoding.value() == "utf-8") {
-    return std::string(static_cast<const char*>(instance.data()),
-                       instance.length());
+namespace {
+
+std::string EncodingName(Optional<std::string>& encoding) {
+  std::string name(encoding.value("utf-8"));
+
+  if (name == "utf8")
+    return "utf-8";
+  else if (name == "binary")
+    return "latin1";
+  else if (name == "utf16le" || name == "ucs2")
+    return "utf-16le";
+
+  return name;
+}
+
+template <typename Function>
+Bytes::Value Transcode(Bytes* cls, size_t capacity, Function function) {
+  void* target = base::Variant::AllocateArrayBufferData(capacity);
+  size_t length;
+
+  try {
+    length = function(target);
+  } catch (utilities::Encoding::Error& error) {
+    base::Variant::FreeArrayBufferData(target, capacity);
+    throw base::TypeError(error.message());
+  }
+
+  return cls->Adopt(target, length);
+}
+
+}
+
+base::Variant Bytes::decode(Value instance,
+                            Optional<std::string> encoding_in) {
+  std::string encoding(EncodingName(encoding_in));
+  const char* data = static_cast<const char*>(instance.data());
+  size_t length = instance.length();
+
+  if (length > static_cast<size_t>(std::numeric_limits<int>::max()) / 2)
+    throw base::RangeError("too long to decode into a string");
+
+  if (encoding == "utf-8" || encoding == "ascii") {
+    /* Pure ASCII is the common case and can skip V8's UTF-8 decoder. */
+    if (utilities::Encoding::IsASCII(data, length))
+      return base::String::NewFromOneByte(data, length);
+    return base::String::New(data, length);
+  } else if (encoding == "latin1") {
+    return base::String::NewFromOneByte(data, length);
+  } else if (encoding == "utf-16le") {
+    size_t units = length / 2;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (reinterpret_cast<uintptr_t>(data) % 2 == 0)
+      return base::String::NewFromTwoByte(
+          reinterpret_cast<const std::uint16_t*>(data), units);
+#endif
+
+    std::unique_ptr<std::uint16_t[]> buffer(new std::uint16_t[units]);
+    for (size_t index = 0; index < units; ++index)
+      buffer[index] = static_cast<unsigned char>(data[2 * index]) |
+          (static_cast<unsigned char>(data[2 * index + 1]) << 8);
+    return base::String::NewFromTwoByte(buffer.get(), units);
+  } else if (encoding == "hex") {
+    std::unique_ptr<char[]> buffer(new char[2 * length]);
+    utilities::Encoding::EncodeHex(data, length, buffer.get());
+    return base::String::NewFromOneByte(buffer.get(), 2 * length);
+  } else if (encoding == "base64" || encoding == "base64url") {
+    bool url = encoding == "base64url";
+    size_t encoded_length = utilities::Encoding::Base64Length(length, url);
+    std::unique_ptr<char[]> buffer(new char[encoded_length]);
+    utilities::Encoding::EncodeBase64(data, length, buffer.get(), url);
+    return base::String::NewFromOneByte(buffer.get(), encoded_length);
   } else {
     throw base::TypeError("unsupported encoding");
   }
 }
 
-Bytes::Value Bytes::slice(Value instance, Optional<size_t> offset,
-                          Optional<size_t> length) {
-  size_t use_offset;
+bool Bytes::isValidUTF8(Value instance) {
+  return utilities::Encoding::IsValidUTF8(instance.data(), instance.length());
+}
 
-  if (offset.specified())
-    use_offset = std::min(instance.length(), offset.value());
+namespace {
+
+/* A needle is either a single byte value or a byte sequence (Bytes or a
+   string, which is encoded as UTF-8).  Like Uint8Array.indexOf(), a number
+   that isn't a valid byte value matches nothing. */
+class Needle {
+ public:
+  Needle(const base::Variant& value)
+      : impossible_(false) {
+    if (value.IsNumber()) {
+      double number = value.AsNumber();
+      impossible_ = !(number >= 0 && number <= 255 &&
+                      number == static_cast<unsigned char>(number));
+      byte_ = static_cast<unsigned char>(impossible_ ? 0 : number);
+      data_ = &byte_;
+      length_ = 1;
+    } else {
+      bytes_ = base::AsValue<Bytes::Value>(value);
+      data_ = bytes_.data();
+      length_ = bytes_.length();
+    }
+  }
+
+  const void* data() const { return data_; }
+  size_t length() const { return length_; }
+  bool impossible() const { return impossible_; }
+
+ private:
+  bool impossible_;
+  Bytes::Value bytes_;
+  unsigned char byte_;
+  const void* data_;
+  size_t length_;
+};
+
+/* Offset of the first occurrence of 'needle' at or after 'from', or -1.
+   memchr() and memmem() are vectorized (memmem() uses the Two-Way algorithm)
+   in any reasonable C library. */
+std::int64_t Find(const char* data, size_t length, const Needle& needle,
+                  size_t from) {
+  if (needle.impossible() || from > length ||
+      needle.length() > length - from)
+    return -1;
+
+  const void* found;
+
+  if (needle.length() == 1)
+    found = memchr(data + from, *static_cast<const char*>(needle.data()),
+                   length - from);
   else
-    use_offset = 0;
+    found = memmem(data + from, length - from, needle.data(),
+                   needle.length());
+
+  if (!found)
+    return -1;
+
+  return static_cast<const char*>(found) - data;
+}
+
+/* Offset of the last occurrence of 'needle' starting at or before 'from', or
+   -1.  Candidates are located by their first byte using memrchr(). */
+std::int64_t FindLast(const char* data, size_t length, const Needle& needle,
+                      size_t from) {
+  if (needle.impossible() || needle.length() > length)
+    return -1;
+
+  const char* first = static_cast<const char*>(needle.data());
+  size_t end = std::min(from, length - needle.length()) + 1;
+
+  if (needle.length() == 0)
+    return end - 1;
+
+  while (end != 0) {
+    const void* found = memrchr(data, *first, end);
+
+    if (!found)
+      return -1;
+
+    size_t offset = static_cast<const char*>(found) - data;
+
+    if (memcmp(data + offset + 1, first + 1, needle.length() - 1) == 0)
+      return offset;
+
+    end = offset;
+  }
 
-  size_t use_length = instance.length() - use_offset;
+  return -1;
+}
+
+size_t StartOffset(size_t length, Optional<std::int64_t>& from,
+                   std::int64_t default_value) {
+  std::int64_t value = from.value(default_value);
+
+  if (value < 0)
+    value = std::max<std::int64_t>(0, length + value);
+
+  return std::min<std::uint64_t>(value, length);
+}
+
+void ClampRange(Bytes::Value& instance, Optional<size_t>& offset,
+                Optional<size_t>& length, size_t& use_offset,
+                size_t& use_length) {
+  use_offset = std::min(instance.length(), offset.value(0));
+  use_length = instance.length() - use_offset;
 
   if (length.specified())
     use_length = std::min(use_length, length.value());
+}
+
+}
+
+std::int64_t Bytes::indexOf(Value instance, base::Variant needle_in,
+                            Optional<std::int64_t> from) {
+  Needle needle(needle_in);
+  size_t length = instance.length();
+
+  return Find(static_cast<const char*>(instance.data()), length, needle,
+              StartOffset(length, from, 0));
+}
+
+std::int64_t Bytes::lastIndexOf(Value instance, base::Variant needle_in,
+                                Optional<std::int64_t> from) {
+  Needle needle(needle_in);
+  size_t length = instance.length();
+
+  return FindLast(static_cast<const char*>(instance.data()), length, needle,
+                  StartOffset(length, from, length));
+}
+
+std::int64_t Bytes::count(Value instance, base::Variant needle_in) {
+  Needle needle(needle_in);
+  const char* data = static_cast<const char*>(instance.data());
+  size_t length = instance.length();
+
+  if (needle.length() == 0)
+    throw base::RangeError("empty needle");
+
+  std::int64_t result = 0;
+  std::int64_t offset = 0;
+
+  /* Occurrences are counted without overlapping, like String.split(). */
+  while ((offset = Find(data, length, needle, offset)) != -1) {
+    ++result;
+    offset += needle.length();
+  }
+
+  return result;
+}
+
+std::vector<Bytes::Value> Bytes::split(Value instance,
+                                       base::Variant separator_in,
+                                       Optional<size_t> limit) {
+  Needle separator(separator_in);
+  Bytes* bytes = Bytes::FromContext();
+  const char* data = static_cast<const char*>(instance.data());
+  size_t length = instance.length();
+  size_t max_parts = limit.value(std::numeric_limits<size_t>::max());
+  std::vector<Value> result;
+
+  if (separator.length() == 0)
+    throw base::RangeError("empty separator");
+
+  size_t offset = 0;
+
+  while (result.size() < max_parts) {
+    std::int64_t found = Find(data, length, separator, offset);
+
+    if (found == -1) {
+      result.push_back(bytes->View(instance, offset, length - offset));
+      break;
+    }
+
+    result.push_back(bytes->View(instance, offset, found - offset));
+    offset = found + separator.length();
+  }
+
+  return result;
+}
+
+std::vector<Bytes::Value> Bytes::lines(Value instance) {
+  Bytes* bytes = Bytes::FromContext();
+  const char* data = static_cast<const char*>(instance.data());
+  size_t length = instance.length();
+  std::vector<Value> result;
+
+  size_t offset = 0;
+
+  while (offset < length) {
+    const char* found = static_cast<const char*>(
+        memchr(data + offset, '\n', length - offset));
+    size_t end = found ? found - data : length;
+    size_t next = found ? end + 1 : length;
+
+    if (end > offset && data[end - 1] == '\r' && found)
+      --end;
+
+    result.push_back(bytes->View(instance, offset, end - offset));
+    offset = next;
+  }
+
+  return result;
+}
+
+Bytes::Value Bytes::slice(Value instance, Optional<size_t> offset,
+                          Optional<size_t> length) {
+  size_t use_offset, use_length;
+
+  ClampRange(instance, offset, length, use_offset, use_length);
+
+  return Bytes::FromContext()->View(instance, use_offset, use_length);
+}
+
+Bytes::Value Bytes::copy(Value instance, Optional<size_t> offset,
+                         Optional<size_t> length) {
+  size_t use_offset, use_length;
+
+  ClampRange(instance, offset, length, use_offset, use_length);
 
   return Bytes::FromContext()->New(
       static_cast<char*>(instance.data()) + use_offset, use_length);
 }
 
 Bytes::Value Bytes::concat(Value instance, Value other) {
-  Value result(Bytes::FromContext()->New(instance.length() + other.length()));
+  Value result(Bytes::FromContext()->NewUninitialized(
+      instance.length() + other.length()));
   std::copy(static_cast<char*>(instance.data()),
             static_cast<char*>(instance.data()) + instance.length(),
             static_cast<char*>(result.data()));
@@ -118,17 +426,77 @@ Bytes::Value Bytes::concat(Value instance, Value other) {
   return result;
 }
 
+Bytes::Value Bytes::concatAll(Bytes* cls, std::vector<Value> parts) {
+  size_t length = 0;
+
+  for (auto iter(parts.begin()); iter != parts.end(); ++iter)
+    length += iter->length();
+
+  Value result(cls->NewUninitialized(length));
+  char* target = static_cast<char*>(result.data());
+
+  for (auto iter(parts.begin()); iter != parts.end(); ++iter) {
+    std::copy(static_cast<char*>(iter->data()),
+              static_cast<char*>(iter->data()) + iter->length(),
+              target);
+    target += iter->length();
+  }
+
+  return result;
+}
+
 std::string Bytes::toJSON(Value instance) {
   return std::string(static_cast<char*>(instance.data()), instance.length());
 }
 
+base::Object Bytes::allocatorStatistics(Bytes*) {
+  base::Variant::ArrayBufferStatistics statistics(
+      base::Variant::GetArrayBufferStatistics());
+  base::Object result(base::Object::Create());
+  base::Object allocations(base::Object::Create());
+
+  result.Put("liveBytes", base::Variant::Number(statistics.live_bytes));
+  result.Put("liveBuffers", base::Variant::Number(statistics.live_buffers));
+  result.Put("pooledBytes", base::Variant::Number(statistics.pooled_bytes));
+
+  for (auto iter(statistics.allocations.begin());
+       iter != statistics.allocations.end(); ++iter)
+    allocations.Put(std::to_string(iter->first),
+                    base::Variant::Number(iter->second));
+  allocations.Put("large",
+                  base::Variant::Number(statistics.large_allocations));
+
+  result.Put("allocations", allocations);
+  return result;
+}
+
 Bytes::Value Bytes::encode(Bytes* cls, std::string data,
-                           Optional<std::string> encoding) {
-  if (!encoding.specified() ||
-      encoding.value() == "utf-8")
+                           Optional<std::string> encoding_in) {
+  std::string encoding(EncodingName(encoding_in));
+  const char* source = data.data();
+  size_t length = data.length();
+
+  if (encoding == "utf-8" || encoding == "ascii") {
     return cls->New(data);
-  else
+  } else if (encoding == "latin1") {
+    return Transcode(cls, length, [=](void* target) {
+        return utilities::Encoding::UTF8ToLatin1(source, length, target);
+      });
+  } else if (encoding == "utf-16le") {
+    return Transcode(cls, 2 * length, [=](void* target) {
+        return utilities::Encoding::UTF8ToUTF16LE(source, length, target);
+      });
+  } else if (encoding == "hex") {
+    return Transcode(cls, length / 2, [=](void* target) {
+        return utilities::Encoding::DecodeHex(source, length, target);
+      });
+  } else if (encoding == "base64" || encoding == "base64url") {
+    return Transcode(cls, (length + 3) / 4 * 3, [=](void* target) {
+        return utilities::Encoding::DecodeBase64(source, length, target);
+      });
+  } else {
     throw base::TypeError("unsupported encoding");
+  }
 }
 
 }
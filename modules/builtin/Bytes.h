@@ -58,6 +58,16 @@ class Bytes : public api::Class {
   Value New(const std::string& data);
   Value New(const void* data, size_t length);
   Value New(size_t length);
+  Value NewUninitialized(size_t length);
+  /**< Like New(size_t), but without zeroing the contents, for callers that
+       overwrite all of them straight away. */
+  Value Adopt(void* data, size_t length);
+  /**< Return a Bytes object that takes ownership of 'data', which must have
+       been allocated by base::Variant::AllocateArrayBufferData(). */
+  Value View(Value source, size_t offset, size_t length);
+  /**< Return a Bytes object referencing 'length' bytes of 'source', starting
+       at 'offset', without copying them.  Modifications made through either
+       object are visible through the other. */
 
   static Bytes* FromContext(
       v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
@@ -65,13 +75,27 @@ class Bytes : public api::Class {
  private:
   static Value constructor(Bytes*, size_t length);
 
-  static std::string decode(Value, Optional<std::string> encoding);
+  static base::Variant decode(Value, Optional<std::string> encoding);
+  static bool isValidUTF8(Value);
+
+  static std::int64_t indexOf(Value, base::Variant needle,
+                              Optional<std::int64_t> from);
+  static std::int64_t lastIndexOf(Value, base::Variant needle,
+                                  Optional<std::int64_t> from);
+  static std::int64_t count(Value, base::Variant needle);
+  static std::vector<Value> split(Value, base::Variant separator,
+                                  Optional<size_t> limit);
+  static std::vector<Value> lines(Value);
 
   static Value slice(Value, Optional<size_t> offset, Optional<size_t> length);
+  static Value copy(Value, Optional<size_t> offset, Optional<size_t> length);
   static Value concat(Value instance, Value other);
+  static Value concatAll(Bytes* cls, std::vector<Value> parts);
 
   static std::string toJSON(Value);
 
+  static base::Object allocatorStatistics(Bytes* cls);
+
   static Value encode(Bytes* cls, std::string data,
                       Optional<std::string> encoding);
 };
@@ -0,0 +1,192 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "modules/builtin/BytesBuilder.h"
+
+#include <string.h>
+
+#include "modules/BuiltIn.h"
+
+namespace modules {
+namespace builtin {
+
+class BytesBuilder::Instance : public api::Class::Instance<BytesBuilder> {
+ public:
+  Instance(size_t capacity);
+  ~Instance();
+
+  char* Reserve(size_t nbytes);
+  void Append(const void* data, size_t nbytes);
+
+  template <typename Type>
+  void AppendInteger(Type value, bool big_endian);
+
+  char* data;
+  size_t length;
+  size_t capacity;
+};
+
+BytesBuilder::Instance::Instance(size_t capacity)
+    : data(NULL)
+    , length(0)
+    , capacity(0) {
+  if (capacity != 0) {
+    data = static_cast<char*>(
+        base::Variant::AllocateArrayBufferData(capacity));
+    this->capacity = capacity;
+  }
+}
+
+BytesBuilder::Instance::~Instance() {
+  if (data)
+    base::Variant::FreeArrayBufferData(data, capacity);
+}
+
+char* BytesBuilder::Instance::Reserve(size_t nbytes) {
+  if (capacity - length < nbytes) {
+    size_t new_capacity = std::max<size_t>(capacity * 2, 256);
+
+    if (new_capacity - length < nbytes)
+      new_capacity = length + nbytes;
+
+    char* new_data = static_cast<char*>(
+        base::Variant::AllocateArrayBufferData(new_capacity));
+
+    if (data) {
+      memcpy(new_data, data, length);
+      base::Variant::FreeArrayBufferData(data, capacity);
+    }
+
+    data = new_data;
+    capacity = new_capacity;
+  }
+
+  char* target = data + length;
+  length += nbytes;
+  return target;
+}
+
+void BytesBuilder::Instance::Append(const void* source, size_t nbytes) {
+  memcpy(Reserve(nbytes), source, nbytes);
+}
+
+template <typename Type>
+void BytesBuilder::Instance::AppendInteger(Type value, bool big_endian) {
+  unsigned char* target = reinterpret_cast<unsigned char*>(
+      Reserve(sizeof value));
+
+  for (unsigned index = 0; index < sizeof value; ++index) {
+    unsigned shift = 8 * (big_endian ? sizeof value - 1 - index : index);
+    target[index] = value >> shift;
+  }
+}
+
+BytesBuilder::BytesBuilder()
+    : api::Class("BytesBuilder", &constructor) {
+  AddMethod<BytesBuilder>("append", &append);
+  AddMethod<BytesBuilder>("appendUInt8", &appendUInt8);
+  AddMethod<BytesBuilder>("appendUInt16LE", &appendUInt16LE);
+  AddMethod<BytesBuilder>("appendUInt16BE", &appendUInt16BE);
+  AddMethod<BytesBuilder>("appendUInt32LE", &appendUInt32LE);
+  AddMethod<BytesBuilder>("appendUInt32BE", &appendUInt32BE);
+  AddMethod<BytesBuilder>("appendFloat64LE", &appendFloat64LE);
+  AddMethod<BytesBuilder>("appendFloat64BE", &appendFloat64BE);
+  AddMethod<BytesBuilder>("finish", &finish);
+  AddProperty<BytesBuilder>("length", &get_length);
+  AddProperty<BytesBuilder>("capacity", &get_capacity);
+}
+
+BytesBuilder* BytesBuilder::FromContext(v8::Handle<v8::Context> context) {
+  return BuiltIn::FromContext(context)->bytes_builder();
+}
+
+BytesBuilder::Instance* BytesBuilder::constructor(BytesBuilder*,
+                                                  Optional<size_t> capacity) {
+  return new Instance(capacity.value(0));
+}
+
+void BytesBuilder::append(Instance* instance, Bytes::Value data) {
+  instance->Append(data.data(), data.length());
+}
+
+void BytesBuilder::appendUInt8(Instance* instance, unsigned value) {
+  instance->AppendInteger<std::uint8_t>(value, false);
+}
+
+void BytesBuilder::appendUInt16LE(Instance* instance, unsigned value) {
+  instance->AppendInteger<std::uint16_t>(value, false);
+}
+
+void BytesBuilder::appendUInt16BE(Instance* instance, unsigned value) {
+  instance->AppendInteger<std::uint16_t>(value, true);
+}
+
+void BytesBuilder::appendUInt32LE(Instance* instance, unsigned value) {
+  instance->AppendInteger<std::uint32_t>(value, false);
+}
+
+void BytesBuilder::appendUInt32BE(Instance* instance, unsigned value) {
+  instance->AppendInteger<std::uint32_t>(value, true);
+}
+
+void BytesBuilder::appendFloat64LE(Instance* instance, double value) {
+  std::uint64_t bits;
+  memcpy(&bits, &value, sizeof bits);
+  instance->AppendInteger<std::uint64_t>(bits, false);
+}
+
+void BytesBuilder::appendFloat64BE(Instance* instance, double value) {
+  std::uint64_t bits;
+  memcpy(&bits, &value, sizeof bits);
+  instance->AppendInteger<std::uint64_t>(bits, true);
+}
+
+Bytes::Value BytesBuilder::finish(Instance* instance) {
+  Bytes* bytes = Bytes::FromContext();
+
+  if (!instance->data)
+    return bytes->New(static_cast<size_t>(0));
+
+  /* The built buffer is handed over as is, unless it is mostly unused; then
+     the result is copied, so as not to keep the unused capacity alive. */
+  Bytes::Value result;
+
+  if (instance->length < instance->capacity / 2) {
+    result = bytes->New(instance->data, instance->length);
+    base::Variant::FreeArrayBufferData(instance->data, instance->capacity);
+  } else {
+    result = bytes->Adopt(instance->data, instance->length);
+  }
+
+  instance->data = NULL;
+  instance->length = instance->capacity = 0;
+
+  return result;
+}
+
+std::int64_t BytesBuilder::get_length(Instance* instance) {
+  return instance->length;
+}
+
+std::int64_t BytesBuilder::get_capacity(Instance* instance) {
+  return instance->capacity;
+}
+
+}
+}
@@ -0,0 +1,59 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef MODULES_BUILTIN_BYTESBUILDER_H
+#define MODULES_BUILTIN_BYTESBUILDER_H
+
+#include "api/Class.h"
+#include "modules/builtin/Bytes.h"
+
+namespace modules {
+namespace builtin {
+
+class BytesBuilder : public api::Class {
+ public:
+  class Instance;
+
+  BytesBuilder();
+
+  static BytesBuilder* FromContext(
+      v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
+
+ private:
+  static Instance* constructor(BytesBuilder*, Optional<size_t> capacity);
+
+  static void append(Instance* instance, Bytes::Value data);
+  static void appendUInt8(Instance* instance, unsigned value);
+  static void appendUInt16LE(Instance* instance, unsigned value);
+  static void appendUInt16BE(Instance* instance, unsigned value);
+  static void appendUInt32LE(Instance* instance, unsigned value);
+  static void appendUInt32BE(Instance* instance, unsigned value);
+  static void appendFloat64LE(Instance* instance, double value);
+  static void appendFloat64BE(Instance* instance, double value);
+
+  static Bytes::Value finish(Instance* instance);
+
+  static std::int64_t get_length(Instance* instance);
+  static std::int64_t get_capacity(Instance* instance);
+};
+
+}
+}
+
+#endif // MODULES_BUILTIN_BYTESBUILDER_H
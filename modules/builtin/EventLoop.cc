@@ -0,0 +1,575 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#include "Base.h"
+#include "modules/builtin/EventLoop.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <exception>
+#include <limits>
+
+#include "modules/BuiltIn.h"
+#include "modules/io/IOError.h"
+#include "utilities/Mutex.h"
+#include "utilities/ThreadPool.h"
+
+namespace modules {
+namespace builtin {
+
+namespace {
+
+double Now() {
+  struct timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+class AttemptHandler : public EventLoop::Handler {
+ public:
+  AttemptHandler(EventLoop::Attempt attempt, base::Object keep_alive)
+      : attempt_(attempt)
+      , keep_alive_(keep_alive) {
+  }
+
+  virtual bool Ready(std::uint32_t) override {
+    try {
+      return !attempt_(promise_);
+    } catch (base::Error& error) {
+      promise_.Reject(error);
+      return false;
+    }
+  }
+
+  virtual void Cancel(const std::string& reason) override {
+    io::IOError error(reason);
+    promise_.Reject(error);
+  }
+
+  base::Object GetPromise() { return promise_.GetObject(); }
+
+ private:
+  EventLoop::Attempt attempt_;
+  EventLoop::Promise promise_;
+  base::Object::Persistent keep_alive_;
+};
+
+}
+
+struct EventLoop::Background {
+  Background(Completion completion, base::Object keep_alive)
+      : completion(completion)
+      , keep_alive(keep_alive) {
+  }
+
+  Completion completion;
+  Promise promise;
+  base::Object::Persistent keep_alive;
+};
+
+/* Background work that has finished, waiting for its completion to be run.
+   Shared with the pool threads, which may outlive the event loop. */
+struct EventLoop::Completed {
+  Completed()
+      : fd(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+  }
+
+  ~Completed() {
+    if (fd != -1)
+      ::close(fd);
+  }
+
+  utilities::Mutex mutex;
+  std::vector<unsigned> ids;
+  std::unordered_map<unsigned, std::string> failures;
+  int fd;
+};
+
+class EventLoop::BackgroundHandler : public EventLoop::Handler {
+ public:
+  BackgroundHandler(EventLoop& event_loop)
+      : event_loop_(event_loop) {
+  }
+
+  virtual bool Ready(std::uint32_t) override {
+    return event_loop_.RunCompleted();
+  }
+
+ private:
+  EventLoop& event_loop_;
+};
+
+EventLoop::Promise::Promise()
+    : resolver_(CurrentIsolate(),
+                v8::Promise::Resolver::New(CurrentContext()).ToLocalChecked()) {
+}
+
+base::Object EventLoop::Promise::GetObject() {
+  return v8::Local<v8::Promise::Resolver>::New(
+      CurrentIsolate(), resolver_)->GetPromise();
+}
+
+void EventLoop::Promise::Resolve(base::Variant value) {
+  v8::Local<v8::Promise::Resolver> resolver(
+      v8::Local<v8::Promise::Resolver>::New(CurrentIsolate(), resolver_));
+  Check(resolver->Resolve(CurrentContext(), value.handle()));
+}
+
+void EventLoop::Promise::Reject(base::Error& error) {
+  v8::Local<v8::Promise::Resolver> resolver(
+      v8::Local<v8::Promise::Resolver>::New(CurrentIsolate(), resolver_));
+  Check(resolver->Reject(CurrentContext(), error.ToObject().handle()));
+}
+
+EventLoop::EventLoop()
+    : epfd_(::epoll_create1(EPOLL_CLOEXEC))
+    , next_id_(1)
+    , next_sequence_(0)
+    , completed_(new Completed)
+    , background_watch_(0)
+    , running_(false) {
+}
+
+EventLoop::~EventLoop() {
+  if (epfd_ != -1)
+    ::close(epfd_);
+}
+
+unsigned EventLoop::AddTimer(double delay, bool repeat, Handler* handler) {
+  /* Like browsers, treat missing, negative and non-numeric delays as zero. */
+  if (!(delay > 0))
+    delay = 0;
+
+  unsigned id = next_id_++;
+  Timer& timer(timers_[id]);
+
+  timer.interval = delay;
+  timer.repeat = repeat;
+  timer.handler.reset(handler);
+
+  Schedule(id, delay);
+  return id;
+}
+
+void EventLoop::RemoveTimer(unsigned id) {
+  timers_.erase(id);
+}
+
+unsigned EventLoop::AddWatch(int fd, std::uint32_t events, Handler* handler) {
+  std::unique_ptr<Handler> owned(handler);
+
+  if (epfd_ == -1)
+    throw io::IOError("epoll_create1() failed", errno);
+
+  std::unordered_map<int, Descriptor>::iterator iter(descriptors_.find(fd));
+
+  if (iter != descriptors_.end()) {
+    struct epoll_event event;
+
+    event.events = iter->second.events;
+    event.data.fd = fd;
+
+    /* If the registration is gone, the file descriptor was closed without
+       CancelWatches() (and the number possibly reused); the old watches
+       would never trigger. */
+    if (::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &event) == -1) {
+      CancelWatches(fd);
+      iter = descriptors_.end();
+    }
+  }
+
+  if (iter == descriptors_.end()) {
+    struct epoll_event event;
+
+    event.events = events;
+    event.data.fd = fd;
+
+    if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &event) == -1)
+      throw io::IOError("epoll_ctl() failed", errno);
+
+    iter = descriptors_.insert(std::make_pair(fd, Descriptor())).first;
+    iter->second.events = events;
+  }
+
+  unsigned id = next_id_++;
+  Watch& watch(watches_[id]);
+
+  watch.fd = fd;
+  watch.events = events;
+  watch.handler.reset(owned.release());
+  iter->second.ids.push_back(id);
+
+  Update(fd);
+  return id;
+}
+
+void EventLoop::RemoveWatch(unsigned id) {
+  std::unordered_map<unsigned, Watch>::iterator iter(watches_.find(id));
+
+  if (iter == watches_.end())
+    return;
+
+  int fd = iter->second.fd;
+  std::vector<unsigned>& ids(descriptors_[fd].ids);
+
+  ids.erase(std::find(ids.begin(), ids.end(), id));
+  watches_.erase(iter);
+
+  Update(fd);
+}
+
+void EventLoop::CancelWatches(int fd) {
+  std::unordered_map<int, Descriptor>::iterator iter(descriptors_.find(fd));
+
+  if (iter == descriptors_.end())
+    return;
+
+  std::vector<unsigned> ids(iter->second.ids);
+
+  ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, NULL);
+  descriptors_.erase(iter);
+
+  for (auto id(ids.begin()); id != ids.end(); ++id) {
+    std::unordered_map<unsigned, Watch>::iterator watch(watches_.find(*id));
+    std::shared_ptr<Handler> handler(watch->second.handler);
+
+    watches_.erase(watch);
+    handler->Cancel("file descriptor closed");
+  }
+}
+
+void EventLoop::Update(int fd) {
+  std::unordered_map<int, Descriptor>::iterator iter(descriptors_.find(fd));
+  Descriptor& descriptor(iter->second);
+
+  if (descriptor.ids.empty()) {
+    /* Fails harmlessly if the file descriptor has been closed already. */
+    ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, NULL);
+    descriptors_.erase(iter);
+    return;
+  }
+
+  std::uint32_t events = 0;
+
+  for (auto id(descriptor.ids.begin()); id != descriptor.ids.end(); ++id)
+    events |= watches_[*id].events;
+
+  if (events == descriptor.events)
+    return;
+
+  struct epoll_event event;
+
+  event.events = events;
+  event.data.fd = fd;
+
+  if (::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &event) == 0)
+    descriptor.events = events;
+}
+
+base::Object EventLoop::WhenReady(int fd, std::uint32_t events,
+                                  Attempt attempt, base::Object keep_alive) {
+  AttemptHandler* handler = new AttemptHandler(attempt, keep_alive);
+  base::Object promise(handler->GetPromise());
+  AddWatch(fd, events, handler);
+  return promise;
+}
+
+base::Object EventLoop::WhenTrue(double interval, Attempt attempt,
+                                 base::Object keep_alive) {
+  AttemptHandler* handler = new AttemptHandler(attempt, keep_alive);
+  base::Object promise(handler->GetPromise());
+  AddTimer(interval, true, handler);
+  return promise;
+}
+
+base::Object EventLoop::RunInBackground(Work work, Completion completion,
+                                        base::Object keep_alive) {
+  if (completed_->fd == -1)
+    throw io::IOError("eventfd() failed", errno);
+
+  std::shared_ptr<Background> background(
+      new Background(completion, keep_alive));
+  base::Object promise(background->promise.GetObject());
+
+  /* The completion watch is only kept while there is work in progress, so
+     that it doesn't keep Run() going forever. */
+  if (background_watch_ == 0)
+    background_watch_ = AddWatch(completed_->fd, EPOLLIN,
+                                 new BackgroundHandler(*this));
+
+  unsigned id = next_id_++;
+  std::shared_ptr<Completed> completed(completed_);
+
+  background_[id] = background;
+
+  utilities::ThreadPool::Shared().Submit([work, completed, id]() {
+    /* The thread pool discards exceptions, so catch them here and record the
+       failure; the id must be reported either way, or the promise would never
+       be settled. */
+    std::string failure;
+    bool failed = false;
+
+    try {
+      work();
+    } catch (std::exception& error) {
+      failure = error.what();
+      failed = true;
+    } catch (...) {
+      failure = "background work failed";
+      failed = true;
+    }
+
+    {
+      utilities::Mutex::Lock lock(completed->mutex);
+      completed->ids.push_back(id);
+      if (failed)
+        completed->failures[id] = failure;
+    }
+
+    std::uint64_t one = 1;
+    ::write(completed->fd, &one, sizeof one);
+  });
+
+  return promise;
+}
+
+void EventLoop::Schedule(unsigned id, double delay) {
+  Deadline deadline;
+
+  deadline.time = Now() + delay;
+  deadline.sequence = next_sequence_++;
+  deadline.id = id;
+
+  deadlines_.push(deadline);
+}
+
+void EventLoop::RunTimers() {
+  double now = Now();
+
+  /* Only run timers that were scheduled before this call, so that intervals
+     rescheduled below can't keep this loop going forever. */
+  std::uint64_t limit = next_sequence_;
+
+  while (!deadlines_.empty() && deadlines_.top().time <= now &&
+         deadlines_.top().sequence < limit) {
+    unsigned id = deadlines_.top().id;
+    deadlines_.pop();
+
+    std::unordered_map<unsigned, Timer>::iterator iter(timers_.find(id));
+    if (iter == timers_.end())
+      continue;
+
+    /* Keep the handler alive while it runs, even if it removes its own
+       timer. */
+    std::shared_ptr<Handler> handler(iter->second.handler);
+
+    if (iter->second.repeat)
+      Schedule(id, iter->second.interval);
+    else
+      timers_.erase(iter);
+
+    v8::HandleScope handle_scope(CurrentIsolate());
+
+    if (!handler->Ready(0))
+      timers_.erase(id);
+
+    Checkpoint();
+  }
+}
+
+void EventLoop::Checkpoint() {
+  CurrentIsolate()->RunMicrotasks();
+}
+
+bool EventLoop::RunCompleted() {
+  std::uint64_t count;
+  std::deque<unsigned> ids;
+
+  ::read(completed_->fd, &count, sizeof count);
+
+  {
+    utilities::Mutex::Lock lock(completed_->mutex);
+    ids.assign(completed_->ids.begin(), completed_->ids.end());
+    completed_->ids.clear();
+  }
+
+  while (!ids.empty()) {
+    std::unordered_map<unsigned, std::shared_ptr<Background>>::iterator iter(
+        background_.find(ids.front()));
+    std::shared_ptr<Background> background(iter->second);
+
+    std::string failure;
+    bool failed = false;
+
+    {
+      utilities::Mutex::Lock lock(completed_->mutex);
+      std::unordered_map<unsigned, std::string>::iterator failure_iter(
+          completed_->failures.find(ids.front()));
+      if (failure_iter != completed_->failures.end()) {
+        failure = failure_iter->second;
+        failed = true;
+        completed_->failures.erase(failure_iter);
+      }
+    }
+
+    background_.erase(iter);
+    ids.pop_front();
+
+    try {
+      if (failed) {
+        io::IOError error(failure);
+        background->promise.Reject(error);
+      } else {
+        background->completion(background->promise);
+      }
+    } catch (base::Error& error) {
+      background->promise.Reject(error);
+    } catch (...) {
+      /* An exception from script code stops the loop; put back the rest, so
+         that their promises are still settled if it is run again. */
+      utilities::Mutex::Lock lock(completed_->mutex);
+      completed_->ids.insert(completed_->ids.end(), ids.begin(), ids.end());
+      std::uint64_t one = 1;
+      ::write(completed_->fd, &one, sizeof one);
+      throw;
+    }
+
+    Checkpoint();
+  }
+
+  if (background_.empty()) {
+    background_watch_ = 0;
+    return false;
+  }
+
+  return true;
+}
+
+void EventLoop::Run() {
+  if (running_)
+    throw base::TypeError("event loop already running");
+
+  class Running {
+   public:
+    Running(bool& running)
+        : running_(running) {
+      running_ = true;
+    }
+    ~Running() {
+      running_ = false;
+    }
+
+   private:
+    bool& running_;
+  };
+
+  Running running(running_);
+  struct epoll_event events[64];
+
+  Checkpoint();
+
+  while (!timers_.empty() || !watches_.empty()) {
+    int timeout = -1;
+
+    /* Drop removed timers from the front of the queue, so that they don't
+       cause needless wake-ups. */
+    while (!deadlines_.empty() &&
+           timers_.find(deadlines_.top().id) == timers_.end())
+      deadlines_.pop();
+
+    if (!deadlines_.empty())
+      timeout = std::min(
+          std::max(0.0, std::ceil(deadlines_.top().time - Now())),
+          static_cast<double>(std::numeric_limits<int>::max()));
+
+    int nevents = 0;
+
+    if (watches_.empty()) {
+      if (timeout > 0) {
+        struct timespec delay = { timeout / 1000, (timeout % 1000) * 1000000 };
+        ::nanosleep(&delay, NULL);
+      }
+    } else {
+      nevents = ::epoll_wait(epfd_, events, 64, timeout);
+
+      if (nevents == -1) {
+        if (errno != EINTR)
+          throw io::IOError("epoll_wait() failed", errno);
+        nevents = 0;
+      }
+    }
+
+    for (int index = 0; index < nevents; ++index) {
+      int fd = events[index].data.fd;
+      std::uint32_t ready = events[index].events;
+      std::unordered_map<int, Descriptor>::iterator iter(
+          descriptors_.find(fd));
+
+      /* Removed by an earlier callback in this round. */
+      if (iter == descriptors_.end())
+        continue;
+
+      /* A hang-up or error ends all watches of the file descriptor, since
+         it would otherwise be reported over and over. */
+      bool failed = (ready & (EPOLLHUP | EPOLLERR)) != 0;
+      std::vector<unsigned> ids(iter->second.ids);
+
+      for (auto id(ids.begin()); id != ids.end(); ++id) {
+        std::unordered_map<unsigned, Watch>::iterator watch(
+            watches_.find(*id));
+
+        /* Removed by an earlier callback. */
+        if (watch == watches_.end())
+          continue;
+
+        std::uint32_t relevant = ready & (watch->second.events |
+                                          EPOLLHUP | EPOLLERR);
+        if (relevant == 0)
+          continue;
+
+        std::shared_ptr<Handler> handler(watch->second.handler);
+        v8::HandleScope handle_scope(CurrentIsolate());
+
+        if (!handler->Ready(relevant)) {
+          RemoveWatch(*id);
+        } else if (failed && watches_.find(*id) != watches_.end()) {
+          RemoveWatch(*id);
+          handler->Cancel("hang-up or error on file descriptor");
+        }
+
+        Checkpoint();
+      }
+    }
+
+    RunTimers();
+  }
+}
+
+EventLoop* EventLoop::FromContext(v8::Handle<v8::Context> context) {
+  return BuiltIn::FromContext(context)->event_loop();
+}
+
+}
+}
@@ -0,0 +1,182 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#ifndef MODULES_BUILTIN_EVENTLOOP_H
+#define MODULES_BUILTIN_EVENTLOOP_H
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace modules {
+namespace builtin {
+
+class EventLoop {
+ public:
+  class Handler {
+   public:
+    virtual ~Handler() {}
+
+    virtual bool Ready(std::uint32_t events) = 0;
+    /**< Called when a timer expires, with 'events' zero, or when a watched
+         file descriptor is ready, with the epoll events that occurred.
+         Return false to cancel the timer or stop watching. */
+
+    virtual void Cancel(const std::string& reason) {}
+    /**< Called when a watch ends without Ready() having returned false:
+         because the file descriptor was closed, or reported a hang-up or
+         an error that Ready() didn't act on. */
+  };
+
+  class Promise {
+   public:
+    Promise();
+
+    base::Object GetObject();
+
+    void Resolve(base::Variant value);
+    void Reject(base::Error& error);
+
+   private:
+    v8::Global<v8::Promise::Resolver> resolver_;
+  };
+
+  typedef std::function<bool (Promise& promise)> Attempt;
+  typedef std::function<void ()> Work;
+  typedef std::function<void (Promise& promise)> Completion;
+
+  EventLoop();
+  ~EventLoop();
+
+  unsigned AddTimer(double delay, bool repeat, Handler* handler);
+  /**< Call 'handler' after 'delay' milliseconds, and then every 'delay'
+       milliseconds if 'repeat' is true.  The event loop takes ownership of
+       'handler'.  Returns an identifier for RemoveTimer(). */
+  void RemoveTimer(unsigned id);
+
+  unsigned AddWatch(int fd, std::uint32_t events, Handler* handler);
+  /**< Call 'handler' whenever 'fd' is ready for 'events' (EPOLLIN and/or
+       EPOLLOUT).  The event loop takes ownership of 'handler'.  A file
+       descriptor can have any number of watches.  Returns an identifier for
+       RemoveWatch(). */
+  void RemoveWatch(unsigned id);
+
+  void CancelWatches(int fd);
+  /**< Remove all watches of 'fd', cancelling their handlers.  Must be called
+       before 'fd' is closed; a closed file descriptor's watches would never
+       trigger, and keep Run() from returning. */
+
+  base::Object WhenReady(int fd, std::uint32_t events, Attempt attempt,
+                         base::Object keep_alive = base::Object());
+  /**< Return a promise, and call 'attempt' each time 'fd' is ready for
+       'events' until it returns true, by which time it must have settled the
+       promise.  A base::Error thrown by 'attempt' rejects the promise.
+       'keep_alive' is kept from being garbage collected until then. */
+
+  base::Object WhenTrue(double interval, Attempt attempt,
+                        base::Object keep_alive = base::Object());
+  /**< Like WhenReady(), but calls 'attempt' every 'interval' milliseconds,
+       for conditions that can't be waited for with epoll. */
+
+  base::Object RunInBackground(Work work, Completion completion,
+                               base::Object keep_alive = base::Object());
+  /**< Return a promise, run 'work' on the shared thread pool, and then call
+       'completion' on this thread to settle the promise.  'work' must not
+       touch the isolate, and neither may anything it captures; results are
+       best passed on through a std::shared_ptr captured by both functions.
+       A base::Error thrown by 'completion' rejects the promise, and so does
+       any exception thrown by 'work', with an IOError carrying its message.
+       'keep_alive' is kept from being garbage collected until then. */
+
+  void Run();
+  /**< Run timers and watches until there are none left.  An exception
+       thrown by a callback stops the loop and propagates. */
+
+  bool running() const { return running_; }
+
+  static EventLoop* FromContext(
+      v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
+
+ private:
+  struct Timer {
+    double interval;
+    bool repeat;
+    std::shared_ptr<Handler> handler;
+  };
+
+  struct Watch {
+    int fd;
+    std::uint32_t events;
+    std::shared_ptr<Handler> handler;
+  };
+
+  /* A watched file descriptor, registered once with epoll for the union of
+     its watches' events. */
+  struct Descriptor {
+    std::uint32_t events;
+    std::vector<unsigned> ids;
+  };
+
+  /* Entry in the timer queue.  Removed timers are left in the queue and
+     skipped when they reach its front. */
+  struct Deadline {
+    double time;
+    std::uint64_t sequence;
+    unsigned id;
+
+    bool operator< (const Deadline& other) const {
+      /* std::priority_queue puts the greatest element first. */
+      if (time != other.time)
+        return time > other.time;
+      return sequence > other.sequence;
+    }
+  };
+
+  struct Background;
+  struct Completed;
+  class BackgroundHandler;
+
+  void Update(int fd);
+  void Schedule(unsigned id, double delay);
+  void RunTimers();
+  void Checkpoint();
+  bool RunCompleted();
+
+  int epfd_;
+  unsigned next_id_;
+  std::uint64_t next_sequence_;
+  std::unordered_map<unsigned, Timer> timers_;
+  std::unordered_map<unsigned, Watch> watches_;
+  std::unordered_map<int, Descriptor> descriptors_;
+  std::priority_queue<Deadline> deadlines_;
+  std::unordered_map<unsigned, std::shared_ptr<Background>> background_;
+  std::shared_ptr<Completed> completed_;
+  unsigned background_watch_;
+  bool running_;
+};
+
+}
+}
+
+#endif // MODULES_BUILTIN_EVENTLOOP_H
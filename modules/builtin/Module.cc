@@ -26,6 +26,7 @@
 #include "api/Runtime.h"
 #include "modules/Modules.h"
 #include "modules/BuiltIn.h"
+#include "modules/Hash.h"
 #include "modules/IO.h"
 #include "modules/OS.h"
 #include "modules/PostgreSQL.h"
@@ -74,6 +75,7 @@ class Module::Instance : public api::Class::Instance<Module> {
   BuiltIn* builtin;
   IO* io;
   OS* os;
+  Hash* hash;
 #if POSTGRESQL_SUPPORT
   PostgreSQL* postgresql;
 #endif
@@ -134,6 +136,7 @@ Module::Instance::Instance(const Features& features)
     , builtin(NULL)
     , io(NULL)
     , os(NULL)
+    , hash(NULL)
 #if POSTGRESQL_SUPPORT
     , postgresql(NULL)
 #endif
@@ -166,6 +169,11 @@ Module::Instance::Instance(const Features& features)
     os->AddToRuntime(runtime);
   }
 
+  if (!features.Disabled("Hash")) {
+    hash = new Hash(features);
+    hash->AddToRuntime(runtime);
+  }
+
 #if POSTGRESQL_SUPPORT
   if (!features.Disabled("PostgreSQL")) {
     postgresql = new PostgreSQL(features);
@@ -214,6 +222,7 @@ Module::Instance::~Instance() {
 #if POSTGRESQL_SUPPORT
   delete postgresql;
 #endif
+  delete hash;
   delete os;
   delete io;
   delete builtin;
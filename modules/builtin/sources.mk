@@ -13,4 +13,6 @@
 # the License.
 
 common_sources += modules/builtin/Bytes.cc \
+                  modules/builtin/BytesBuilder.cc \
+                  modules/builtin/EventLoop.cc \
                   modules/builtin/Module.cc
@@ -0,0 +1,88 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "modules/hash/Algorithm.h"
+
+#include <string.h>
+
+namespace modules {
+namespace hash {
+
+Algorithm* Algorithm::Create(std::string name, std::uint64_t seed) {
+  if (name == "sha1")
+    return new SHA1;
+  else if (name == "sha256")
+    return new SHA256;
+  else if (name == "xxh64")
+    return new XXH64(seed);
+  else
+    return NULL;
+}
+
+BlockAlgorithm::BlockAlgorithm()
+    : buffered_(0)
+    , total_(0) {
+}
+
+void BlockAlgorithm::Update(const void* data_in, size_t length) {
+  const unsigned char* data = static_cast<const unsigned char*>(data_in);
+
+  total_ += length;
+
+  if (buffered_ != 0) {
+    size_t nbytes = std::min(length, sizeof buffer_ - buffered_);
+    memcpy(buffer_ + buffered_, data, nbytes);
+    buffered_ += nbytes;
+    data += nbytes;
+    length -= nbytes;
+
+    if (buffered_ < sizeof buffer_)
+      return;
+
+    Compress(buffer_, 1);
+    buffered_ = 0;
+  }
+
+  /* Whole blocks are compressed straight from the input. */
+  if (length >= sizeof buffer_) {
+    size_t count = length / sizeof buffer_;
+    Compress(data, count);
+    data += count * sizeof buffer_;
+    length -= count * sizeof buffer_;
+  }
+
+  memcpy(buffer_, data, length);
+  buffered_ = length;
+}
+
+std::string BlockAlgorithm::Digest() {
+  std::uint64_t bits = total_ * 8;
+  unsigned char padding[72] = { 0x80 };
+  size_t padding_length = (buffered_ < 56 ? 56 : 120) - buffered_;
+
+  for (unsigned index = 0; index < 8; ++index)
+    padding[padding_length + index] = bits >> (56 - 8 * index);
+
+  Update(padding, padding_length + 8);
+
+  return Output();
+}
+
+}
+}
@@ -0,0 +1,103 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef MODULES_HASH_ALGORITHM_H
+#define MODULES_HASH_ALGORITHM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace modules {
+namespace hash {
+
+class Algorithm {
+ public:
+  virtual ~Algorithm() {}
+
+  virtual void Update(const void* data, size_t length) = 0;
+  virtual std::string Digest() = 0;
+  /**< Finish the computation and return the raw digest.  The algorithm must
+       not be updated afterwards. */
+
+  static Algorithm* Create(std::string name, std::uint64_t seed = 0);
+  /**< Create "sha1", "sha256" or "xxh64".  Returns NULL for other names.
+       The seed is only used by "xxh64". */
+};
+
+/* Block based Merkle-Damgård hashes (SHA-1 and SHA-256) share buffering and
+   padding; subclasses provide the compression function. */
+class BlockAlgorithm : public Algorithm {
+ public:
+  virtual void Update(const void* data, size_t length) override;
+  virtual std::string Digest() override;
+
+ protected:
+  BlockAlgorithm();
+
+  virtual void Compress(const unsigned char* blocks, size_t count) = 0;
+  virtual std::string Output() = 0;
+
+ private:
+  unsigned char buffer_[64];
+  size_t buffered_;
+  std::uint64_t total_;
+};
+
+class SHA1 : public BlockAlgorithm {
+ public:
+  SHA1();
+
+ private:
+  virtual void Compress(const unsigned char* blocks, size_t count) override;
+  virtual std::string Output() override;
+
+  std::uint32_t state_[5];
+};
+
+class SHA256 : public BlockAlgorithm {
+ public:
+  SHA256();
+
+ private:
+  virtual void Compress(const unsigned char* blocks, size_t count) override;
+  virtual std::string Output() override;
+
+  std::uint32_t state_[8];
+};
+
+class XXH64 : public Algorithm {
+ public:
+  XXH64(std::uint64_t seed);
+
+  virtual void Update(const void* data, size_t length) override;
+  virtual std::string Digest() override;
+
+ private:
+  std::uint64_t seed_;
+  std::uint64_t accumulators_[4];
+  unsigned char buffer_[32];
+  size_t buffered_;
+  std::uint64_t total_;
+};
+
+}
+}
+
+#endif // MODULES_HASH_ALGORITHM_H
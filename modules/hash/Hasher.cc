@@ -0,0 +1,92 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "modules/hash/Hasher.h"
+
+#include "modules/Hash.h"
+#include "modules/hash/Algorithm.h"
+
+namespace modules {
+namespace hash {
+
+class Hasher::Instance : public api::Class::Instance<Hasher> {
+ public:
+  Instance(std::string name, Algorithm* algorithm);
+  ~Instance();
+
+  std::string name;
+  Algorithm* algorithm;
+};
+
+Hasher::Instance::Instance(std::string name, Algorithm* algorithm)
+    : name(name)
+    , algorithm(algorithm) {
+}
+
+Hasher::Instance::~Instance() {
+  delete algorithm;
+}
+
+Hasher::Hasher()
+    : api::Class("Hasher", &constructor) {
+  AddMethod<Hasher>("update", &update);
+  AddMethod<Hasher>("digest", &digest);
+  AddProperty<Hasher>("algorithm", &get_algorithm);
+}
+
+Hasher* Hasher::FromContext(v8::Handle<v8::Context> context) {
+  return Hash::FromContext(context)->hasher();
+}
+
+Hasher::Instance* Hasher::constructor(Hasher*, std::string name,
+                                      utilities::Options options) {
+  Algorithm* algorithm = Algorithm::Create(
+      name, static_cast<std::uint64_t>(options.GetNumber("seed", 0)));
+
+  if (!algorithm)
+    throw base::TypeError("unsupported algorithm: " + name);
+
+  return new Instance(name, algorithm);
+}
+
+void Hasher::update(Instance* instance, builtin::Bytes::Value data) {
+  if (!instance->algorithm)
+    throw base::TypeError("digest already computed");
+
+  instance->algorithm->Update(data.data(), data.length());
+}
+
+builtin::Bytes::Value Hasher::digest(Instance* instance) {
+  if (!instance->algorithm)
+    throw base::TypeError("digest already computed");
+
+  std::string digest(instance->algorithm->Digest());
+
+  delete instance->algorithm;
+  instance->algorithm = NULL;
+
+  return builtin::Bytes::FromContext()->New(digest);
+}
+
+std::string Hasher::get_algorithm(Instance* instance) {
+  return instance->name;
+}
+
+}
+}
@@ -0,0 +1,52 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef MODULES_HASH_HASHER_H
+#define MODULES_HASH_HASHER_H
+
+#include "api/Class.h"
+#include "modules/builtin/Bytes.h"
+#include "utilities/Options.h"
+
+namespace modules {
+namespace hash {
+
+class Hasher : public api::Class {
+ public:
+  class Instance;
+
+  Hasher();
+
+  static Hasher* FromContext(
+      v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
+
+ private:
+  static Instance* constructor(Hasher*, std::string algorithm,
+                               utilities::Options options);
+
+  static void update(Instance* instance, builtin::Bytes::Value data);
+  static builtin::Bytes::Value digest(Instance* instance);
+
+  static std::string get_algorithm(Instance* instance);
+};
+
+}
+}
+
+#endif // MODULES_HASH_HASHER_H
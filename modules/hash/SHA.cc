@@ -0,0 +1,366 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "modules/hash/Algorithm.h"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace modules {
+namespace hash {
+
+namespace {
+
+inline std::uint32_t RotateLeft(std::uint32_t value, unsigned count) {
+  return (value << count) | (value >> (32 - count));
+}
+
+inline std::uint32_t RotateRight(std::uint32_t value, unsigned count) {
+  return (value >> count) | (value << (32 - count));
+}
+
+inline std::uint32_t LoadBigEndian32(const unsigned char* data) {
+  return (static_cast<std::uint32_t>(data[0]) << 24) |
+      (static_cast<std::uint32_t>(data[1]) << 16) |
+      (static_cast<std::uint32_t>(data[2]) << 8) |
+      static_cast<std::uint32_t>(data[3]);
+}
+
+std::string StoreBigEndian32(const std::uint32_t* values, size_t count) {
+  std::string result(4 * count, '\0');
+  for (size_t index = 0; index < count; ++index) {
+    result[4 * index] = values[index] >> 24;
+    result[4 * index + 1] = values[index] >> 16;
+    result[4 * index + 2] = values[index] >> 8;
+    result[4 * index + 3] = values[index];
+  }
+  return result;
+}
+
+const std::uint32_t kSHA256Constants[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+void SHA1Portable(std::uint32_t* state, const unsigned char* blocks,
+                  size_t count) {
+  for (; count != 0; --count, blocks += 64) {
+    std::uint32_t w[80];
+
+    for (unsigned t = 0; t < 16; ++t)
+      w[t] = LoadBigEndian32(blocks + 4 * t);
+    for (unsigned t = 16; t < 80; ++t)
+      w[t] = RotateLeft(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+
+    std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+        e = state[4];
+
+    for (unsigned t = 0; t < 80; ++t) {
+      std::uint32_t f, k;
+
+      if (t < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5a827999;
+      } else if (t < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ed9eba1;
+      } else if (t < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8f1bbcdc;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xca62c1d6;
+      }
+
+      std::uint32_t temporary = RotateLeft(a, 5) + f + e + k + w[t];
+      e = d;
+      d = c;
+      c = RotateLeft(b, 30);
+      b = a;
+      a = temporary;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+  }
+}
+
+void SHA256Portable(std::uint32_t* state, const unsigned char* blocks,
+                    size_t count) {
+  for (; count != 0; --count, blocks += 64) {
+    std::uint32_t w[64];
+
+    for (unsigned t = 0; t < 16; ++t)
+      w[t] = LoadBigEndian32(blocks + 4 * t);
+    for (unsigned t = 16; t < 64; ++t) {
+      std::uint32_t s0 = RotateRight(w[t - 15], 7) ^
+          RotateRight(w[t - 15], 18) ^ (w[t - 15] >> 3);
+      std::uint32_t s1 = RotateRight(w[t - 2], 17) ^
+          RotateRight(w[t - 2], 19) ^ (w[t - 2] >> 10);
+      w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+
+    std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+        e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (unsigned t = 0; t < 64; ++t) {
+      std::uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^
+          RotateRight(e, 25);
+      std::uint32_t ch = (e & f) ^ (~e & g);
+      std::uint32_t temporary1 = h + s1 + ch + kSHA256Constants[t] + w[t];
+      std::uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^
+          RotateRight(a, 22);
+      std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+      std::uint32_t temporary2 = s0 + maj;
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + temporary1;
+      d = c;
+      c = b;
+      b = a;
+      a = temporary1 + temporary2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+#if defined(__x86_64__)
+
+/* The SHA extensions (SHA-NI) need SSSE3 and SSE4.1 for the surrounding
+   shuffles and blends as well. */
+bool HasSHAExtensions() {
+  static const bool supported = []() {
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+        !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+      return false;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+      return false;
+
+    return (ebx & bit_SHA) != 0;
+  }();
+
+  return supported;
+}
+
+template <int Function>
+__attribute__((target("sha,ssse3,sse4.1")))
+inline __m128i SHA1Rounds(__m128i abcd, __m128i e) {
+  return _mm_sha1rnds4_epu32(abcd, e, Function);
+}
+
+__attribute__((target("sha,ssse3,sse4.1")))
+void SHA1Hardware(std::uint32_t* state, const unsigned char* blocks,
+                  size_t count) {
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607ull,
+                                      0x08090a0b0c0d0e0full);
+
+  __m128i abcd = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+  for (; count != 0; --count, blocks += 64) {
+    __m128i abcd_saved = abcd;
+    __m128i e0_saved = e0;
+    __m128i message[4];
+    __m128i previous = abcd;
+
+    /* Each iteration performs four rounds.  The message schedule is kept in
+       a ring of four vectors, each holding the next four words. */
+    for (unsigned group = 0; group < 20; ++group) {
+      __m128i& words = message[group % 4];
+
+      if (group < 4) {
+        words = _mm_shuffle_epi8(
+            _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(blocks + 16 * group)),
+            mask);
+      } else {
+        words = _mm_sha1msg2_epu32(
+            _mm_xor_si128(
+                _mm_sha1msg1_epu32(words, message[(group + 1) % 4]),
+                message[(group + 2) % 4]),
+            message[(group + 3) % 4]);
+      }
+
+      __m128i e;
+
+      if (group == 0)
+        e = _mm_add_epi32(e0, words);
+      else
+        e = _mm_sha1nexte_epu32(previous, words);
+
+      previous = abcd;
+
+      switch (group / 5) {
+        case 0: abcd = SHA1Rounds<0>(abcd, e); break;
+        case 1: abcd = SHA1Rounds<1>(abcd, e); break;
+        case 2: abcd = SHA1Rounds<2>(abcd, e); break;
+        default: abcd = SHA1Rounds<3>(abcd, e); break;
+      }
+    }
+
+    e0 = _mm_sha1nexte_epu32(previous, e0_saved);
+    abcd = _mm_add_epi32(abcd, abcd_saved);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+__attribute__((target("sha,ssse3,sse4.1")))
+void SHA256Hardware(std::uint32_t* state, const unsigned char* blocks,
+                    size_t count) {
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull,
+                                      0x0405060700010203ull);
+
+  __m128i temporary = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1);
+  __m128i state1 = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+  __m128i state0 = _mm_alignr_epi8(temporary, state1, 8);  // ABEF
+  state1 = _mm_blend_epi16(state1, temporary, 0xf0);       // CDGH
+
+  for (; count != 0; --count, blocks += 64) {
+    __m128i state0_saved = state0;
+    __m128i state1_saved = state1;
+    __m128i message[4];
+
+    for (unsigned group = 0; group < 16; ++group) {
+      __m128i& words = message[group % 4];
+
+      if (group < 4) {
+        words = _mm_shuffle_epi8(
+            _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(blocks + 16 * group)),
+            mask);
+      } else {
+        __m128i& last = message[(group + 3) % 4];
+        words = _mm_sha256msg2_epu32(
+            _mm_add_epi32(
+                _mm_sha256msg1_epu32(words, message[(group + 1) % 4]),
+                _mm_alignr_epi8(last, message[(group + 2) % 4], 4)),
+            last);
+      }
+
+      __m128i input = _mm_add_epi32(
+          words, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+              kSHA256Constants + 4 * group)));
+
+      state1 = _mm_sha256rnds2_epu32(state1, state0, input);
+      state0 = _mm_sha256rnds2_epu32(state0, state1,
+                                     _mm_shuffle_epi32(input, 0x0e));
+    }
+
+    state0 = _mm_add_epi32(state0, state0_saved);
+    state1 = _mm_add_epi32(state1, state1_saved);
+  }
+
+  temporary = _mm_shuffle_epi32(state0, 0x1b);              // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xb1);                 // DCHG
+  state0 = _mm_blend_epi16(temporary, state1, 0xf0);        // DCBA
+  state1 = _mm_alignr_epi8(state1, temporary, 8);           // HGFE
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+#endif
+
+}
+
+SHA1::SHA1() {
+  state_[0] = 0x67452301;
+  state_[1] = 0xefcdab89;
+  state_[2] = 0x98badcfe;
+  state_[3] = 0x10325476;
+  state_[4] = 0xc3d2e1f0;
+}
+
+void SHA1::Compress(const unsigned char* blocks, size_t count) {
+#if defined(__x86_64__)
+  if (HasSHAExtensions())
+    return SHA1Hardware(state_, blocks, count);
+#endif
+
+  SHA1Portable(state_, blocks, count);
+}
+
+std::string SHA1::Output() {
+  return StoreBigEndian32(state_, 5);
+}
+
+SHA256::SHA256() {
+  state_[0] = 0x6a09e667;
+  state_[1] = 0xbb67ae85;
+  state_[2] = 0x3c6ef372;
+  state_[3] = 0xa54ff53a;
+  state_[4] = 0x510e527f;
+  state_[5] = 0x9b05688c;
+  state_[6] = 0x1f83d9ab;
+  state_[7] = 0x5be0cd19;
+}
+
+void SHA256::Compress(const unsigned char* blocks, size_t count) {
+#if defined(__x86_64__)
+  if (HasSHAExtensions())
+    return SHA256Hardware(state_, blocks, count);
+#endif
+
+  SHA256Portable(state_, blocks, count);
+}
+
+std::string SHA256::Output() {
+  return StoreBigEndian32(state_, 8);
+}
+
+}
+}
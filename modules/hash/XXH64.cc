@@ -0,0 +1,172 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "modules/hash/Algorithm.h"
+
+#include <string.h>
+
+namespace modules {
+namespace hash {
+
+namespace {
+
+const std::uint64_t kPrime1 = 0x9e3779b185ebca87ull;
+const std::uint64_t kPrime2 = 0xc2b2ae3d27d4eb4full;
+const std::uint64_t kPrime3 = 0x165667b19e3779f9ull;
+const std::uint64_t kPrime4 = 0x85ebca77c2b2ae63ull;
+const std::uint64_t kPrime5 = 0x27d4eb2f165667c5ull;
+
+inline std::uint64_t RotateLeft(std::uint64_t value, unsigned count) {
+  return (value << count) | (value >> (64 - count));
+}
+
+inline std::uint64_t Load64(const unsigned char* data) {
+  std::uint64_t value;
+  memcpy(&value, data, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  return value;
+}
+
+inline std::uint32_t Load32(const unsigned char* data) {
+  std::uint32_t value;
+  memcpy(&value, data, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap32(value);
+#endif
+  return value;
+}
+
+inline std::uint64_t Round(std::uint64_t accumulator, std::uint64_t input) {
+  accumulator += input * kPrime2;
+  accumulator = RotateLeft(accumulator, 31);
+  return accumulator * kPrime1;
+}
+
+inline std::uint64_t Merge(std::uint64_t hash, std::uint64_t accumulator) {
+  hash ^= Round(0, accumulator);
+  return hash * kPrime1 + kPrime4;
+}
+
+}
+
+XXH64::XXH64(std::uint64_t seed)
+    : seed_(seed)
+    , buffered_(0)
+    , total_(0) {
+  accumulators_[0] = seed + kPrime1 + kPrime2;
+  accumulators_[1] = seed + kPrime2;
+  accumulators_[2] = seed;
+  accumulators_[3] = seed - kPrime1;
+}
+
+void XXH64::Update(const void* data_in, size_t length) {
+  const unsigned char* data = static_cast<const unsigned char*>(data_in);
+
+  total_ += length;
+
+  if (buffered_ + length < sizeof buffer_) {
+    memcpy(buffer_ + buffered_, data, length);
+    buffered_ += length;
+    return;
+  }
+
+  if (buffered_ != 0) {
+    size_t nbytes = sizeof buffer_ - buffered_;
+    memcpy(buffer_ + buffered_, data, nbytes);
+    data += nbytes;
+    length -= nbytes;
+
+    for (unsigned lane = 0; lane < 4; ++lane)
+      accumulators_[lane] = Round(accumulators_[lane],
+                                  Load64(buffer_ + 8 * lane));
+    buffered_ = 0;
+  }
+
+  /* Four independent lanes, which the compiler keeps in registers. */
+  std::uint64_t v1 = accumulators_[0], v2 = accumulators_[1],
+      v3 = accumulators_[2], v4 = accumulators_[3];
+
+  for (; length >= 32; data += 32, length -= 32) {
+    v1 = Round(v1, Load64(data));
+    v2 = Round(v2, Load64(data + 8));
+    v3 = Round(v3, Load64(data + 16));
+    v4 = Round(v4, Load64(data + 24));
+  }
+
+  accumulators_[0] = v1;
+  accumulators_[1] = v2;
+  accumulators_[2] = v3;
+  accumulators_[3] = v4;
+
+  memcpy(buffer_, data, length);
+  buffered_ = length;
+}
+
+std::string XXH64::Digest() {
+  std::uint64_t hash;
+
+  if (total_ >= 32) {
+    hash = RotateLeft(accumulators_[0], 1) + RotateLeft(accumulators_[1], 7) +
+        RotateLeft(accumulators_[2], 12) + RotateLeft(accumulators_[3], 18);
+
+    for (unsigned lane = 0; lane < 4; ++lane)
+      hash = Merge(hash, accumulators_[lane]);
+  } else {
+    hash = seed_ + kPrime5;
+  }
+
+  hash += total_;
+
+  const unsigned char* data = buffer_;
+  size_t length = buffered_;
+
+  for (; length >= 8; data += 8, length -= 8) {
+    hash ^= Round(0, Load64(data));
+    hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+  }
+
+  if (length >= 4) {
+    hash ^= static_cast<std::uint64_t>(Load32(data)) * kPrime1;
+    hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+    data += 4;
+    length -= 4;
+  }
+
+  for (; length != 0; ++data, --length) {
+    hash ^= *data * kPrime5;
+    hash = RotateLeft(hash, 11) * kPrime1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+
+  /* Canonical (big endian) representation, as printed by xxhsum. */
+  std::string result(8, '\0');
+  for (unsigned index = 0; index < 8; ++index)
+    result[index] = hash >> (56 - 8 * index);
+  return result;
+}
+
+}
+}
@@ -0,0 +1,583 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#include "Base.h"
+#include "modules/io/Batch.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#endif
+
+#include <algorithm>
+#include <memory>
+
+#include "modules/io/Stat.h"
+#include "utilities/ThreadPool.h"
+
+namespace modules {
+namespace io {
+
+namespace {
+
+void Fail(Batch::Operation& operation, const char* call, int error) {
+  operation.failed_call = call;
+  operation.error = error;
+}
+
+/* Read from 'fd' until EOF, appending to the operation's contents if it has
+   any already, or else into a new buffer allocated for an ArrayBuffer.
+   'size_hint' is the expected size, if known. */
+void ReadAll(Batch::Operation& operation, int fd, size_t size_hint) {
+  char* data = static_cast<char*>(operation.data);
+  size_t length = operation.length;
+  size_t capacity = operation.capacity;
+
+  if (!data) {
+    capacity = std::max<size_t>(size_hint + 1, 4096);
+    data = static_cast<char*>(
+        base::Variant::AllocateArrayBufferData(capacity));
+    length = 0;
+  }
+
+  while (true) {
+    if (length == capacity) {
+      char* new_data = static_cast<char*>(
+          base::Variant::AllocateArrayBufferData(capacity * 2));
+      memcpy(new_data, data, length);
+      base::Variant::FreeArrayBufferData(data, capacity);
+      data = new_data;
+      capacity *= 2;
+    }
+
+    ssize_t nread = ::read(fd, data + length, capacity - length);
+
+    if (nread == -1) {
+      if (errno == EINTR)
+        continue;
+      Fail(operation, "read()", errno);
+      base::Variant::FreeArrayBufferData(data, capacity);
+      operation.data = NULL;
+      operation.length = 0;
+      operation.capacity = 0;
+      return;
+    }
+
+    if (nread == 0)
+      break;
+
+    length += nread;
+  }
+
+  operation.data = data;
+  operation.length = length;
+  operation.capacity = capacity;
+}
+
+/* Finish a write that the kernel performed only partially. */
+void WriteRest(Batch::Operation& operation, int fd, size_t offset) {
+  const char* input = static_cast<const char*>(operation.input);
+
+  while (offset < operation.input_length) {
+    ssize_t nwritten = ::pwrite(fd, input + offset,
+                                operation.input_length - offset, offset);
+
+    if (nwritten == -1) {
+      if (errno == EINTR)
+        continue;
+      Fail(operation, "write()", errno);
+      return;
+    }
+
+    offset += nwritten;
+  }
+}
+
+}
+
+void Batch::Perform(Operation& operation) {
+  switch (operation.type) {
+    case Operation::kStat:
+      if (::stat(operation.path.c_str(), &operation.status) == -1)
+        Fail(operation, "stat()", errno);
+      return;
+
+    case Operation::kLStat:
+      if (::lstat(operation.path.c_str(), &operation.status) == -1)
+        Fail(operation, "lstat()", errno);
+      return;
+
+    case Operation::kRead: {
+      int fd = ::open(operation.path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd == -1) {
+        Fail(operation, "open()", errno);
+        return;
+      }
+      struct stat status;
+      size_t size_hint = 0;
+      if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode))
+        size_hint = status.st_size;
+      ReadAll(operation, fd, size_hint);
+      ::close(fd);
+      return;
+    }
+
+    case Operation::kWrite: {
+      int fd = ::open(operation.path.c_str(),
+                      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+      if (fd == -1) {
+        Fail(operation, "open()", errno);
+        return;
+      }
+      WriteRest(operation, fd, 0);
+      if (::close(fd) == -1 && !operation.error)
+        Fail(operation, "close()", errno);
+      return;
+    }
+  }
+}
+
+namespace {
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+
+/* Minimal io_uring wrapper using the raw system calls, so that liburing is
+   not required.  Operations are submitted in stages; each stage submits up
+   to one ring's worth of operations and waits for all of them to complete
+   before the next group is submitted. */
+class Ring {
+ public:
+  Ring(unsigned entries);
+  ~Ring();
+
+  bool ok() const { return fd_ != -1; }
+  int error() const { return error_; }
+
+  bool Supports(const std::vector<int>& opcodes);
+
+  template <typename Prepare, typename Complete>
+  void Stage(const std::vector<size_t>& items, Prepare prepare,
+             Complete complete);
+
+ private:
+  int fd_;
+  unsigned entries_;
+  int error_;
+
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  struct io_uring_sqe* sqes_;
+  size_t sqes_size_;
+
+  unsigned* sq_tail_;
+  unsigned* sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned* cq_mask_;
+  struct io_uring_cqe* cqes_;
+};
+
+Ring::Ring(unsigned entries)
+    : fd_(-1)
+    , error_(0)
+    , sq_ring_(MAP_FAILED)
+    , cq_ring_(MAP_FAILED)
+    , sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED)) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof params);
+
+  int fd = ::syscall(__NR_io_uring_setup, entries, &params);
+  if (fd == -1)
+    return;
+
+  entries_ = params.sq_entries;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes +
+                  params.cq_entries * sizeof(struct io_uring_cqe);
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap)
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+  sq_ring_ = ::mmap(NULL, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (single_mmap)
+    cq_ring_ = sq_ring_;
+  else
+    cq_ring_ = ::mmap(NULL, cq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  sqes_ = static_cast<struct io_uring_sqe*>(
+      ::mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED ||
+      sqes_ == MAP_FAILED) {
+    ::close(fd);
+    return;
+  }
+
+  char* sq = static_cast<char*>(sq_ring_);
+  char* cq = static_cast<char*>(cq_ring_);
+
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  fd_ = fd;
+}
+
+Ring::~Ring() {
+  if (sqes_ != MAP_FAILED)
+    ::munmap(sqes_, sqes_size_);
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+    ::munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != MAP_FAILED)
+    ::munmap(sq_ring_, sq_ring_size_);
+  if (fd_ != -1)
+    ::close(fd_);
+}
+
+bool Ring::Supports(const std::vector<int>& opcodes) {
+  const unsigned kOps = 256;
+  size_t size = sizeof(struct io_uring_probe) +
+                kOps * sizeof(struct io_uring_probe_op);
+  std::unique_ptr<char[]> buffer(new char[size]);
+  struct io_uring_probe* probe =
+      reinterpret_cast<struct io_uring_probe*>(buffer.get());
+
+  memset(probe, 0, size);
+
+  if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe,
+                kOps) == -1)
+    return false;
+
+  for (auto iter(opcodes.begin()); iter != opcodes.end(); ++iter)
+    if (*iter > probe->last_op ||
+        !(probe->ops[*iter].flags & IO_URING_OP_SUPPORTED))
+      return false;
+
+  return true;
+}
+
+template <typename Prepare, typename Complete>
+void Ring::Stage(const std::vector<size_t>& items, Prepare prepare,
+                 Complete complete) {
+  for (size_t start = 0; start < items.size(); start += entries_) {
+    unsigned count = std::min<size_t>(entries_, items.size() - start);
+
+    /* Once the ring has failed, the state of its queues is unknown, so the
+       remaining operations are failed without using it. */
+    if (error_) {
+      for (unsigned index = 0; index < count; ++index)
+        complete(items[start + index], -error_);
+      continue;
+    }
+
+    unsigned tail = *sq_tail_;
+
+    /* All earlier submission queue entries have been consumed by the kernel
+       at this point, so entries can be filled in from the start. */
+    for (unsigned index = 0; index < count; ++index) {
+      struct io_uring_sqe* sqe = &sqes_[index];
+      memset(sqe, 0, sizeof *sqe);
+      prepare(sqe, items[start + index]);
+      sqe->user_data = start + index;
+      sq_array_[tail & *sq_mask_] = index;
+      ++tail;
+    }
+
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+    unsigned submitted = 0;
+    unsigned completed = 0;
+
+    /* Completions arrive in any order. */
+    std::vector<bool> done(count, false);
+
+    while (completed < count) {
+      int result = ::syscall(__NR_io_uring_enter, fd_, count - submitted,
+                             count - completed, IORING_ENTER_GETEVENTS,
+                             NULL, 0);
+
+      if (result == -1) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+          continue;
+        /* Shouldn't happen once the ring is set up; report the failure for
+           the operations whose outcome is unknown. */
+        error_ = errno;
+        for (unsigned index = 0; index < count; ++index)
+          if (!done[index])
+            complete(items[start + index], -error_);
+        break;
+      }
+
+      submitted += result;
+
+      unsigned head = *cq_head_;
+      unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+      while (head != cq_tail) {
+        struct io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+        done[cqe->user_data - start] = true;
+        complete(items[cqe->user_data], cqe->res);
+        ++head;
+        ++completed;
+      }
+
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+  }
+}
+
+void PrepareRW(struct io_uring_sqe* sqe, int opcode, int fd, const void* addr,
+               unsigned len, std::uint64_t offset) {
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<std::uint64_t>(addr);
+  sqe->len = len;
+  sqe->off = offset;
+}
+
+const unsigned kRingEntries = 256;
+
+std::vector<int> RequiredOpcodes() {
+  return { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ,
+           IORING_OP_WRITE, IORING_OP_CLOSE };
+}
+
+#endif
+
+}
+
+bool Batch::IsRingSupported() {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+  static const bool supported = []() {
+    Ring ring(1);
+    return ring.ok() && ring.Supports(RequiredOpcodes());
+  }();
+  return supported;
+#else
+  return false;
+#endif
+}
+
+bool Batch::RunRing(std::vector<Operation>& operations) {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+  if (!IsRingSupported())
+    return false;
+
+  Ring ring(kRingEntries);
+
+  if (!ring.ok())
+    return false;
+
+  std::vector<struct statx> statxs(operations.size());
+  std::vector<size_t> first, second, third, closing;
+
+  for (size_t index = 0; index < operations.size(); ++index)
+    first.push_back(index);
+
+  /* Stage 1: stat paths, and open files to read or write. */
+  ring.Stage(first,
+      [&](struct io_uring_sqe* sqe, size_t index) {
+        Operation& operation = operations[index];
+        switch (operation.type) {
+          case Operation::kStat:
+          case Operation::kLStat:
+            PrepareRW(sqe, IORING_OP_STATX, AT_FDCWD, operation.path.c_str(),
+                      STATX_BASIC_STATS,
+                      reinterpret_cast<std::uint64_t>(&statxs[index]));
+            if (operation.type == Operation::kLStat)
+              sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+            break;
+          case Operation::kRead:
+            PrepareRW(sqe, IORING_OP_OPENAT, AT_FDCWD, operation.path.c_str(),
+                      0, 0);
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            break;
+          case Operation::kWrite:
+            PrepareRW(sqe, IORING_OP_OPENAT, AT_FDCWD, operation.path.c_str(),
+                      0666, 0);
+            sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+            break;
+        }
+      },
+      [&](size_t index, int result) {
+        Operation& operation = operations[index];
+        switch (operation.type) {
+          case Operation::kStat:
+          case Operation::kLStat:
+            if (result < 0)
+              Fail(operation, operation.type == Operation::kStat
+                   ? "stat()" : "lstat()", -result);
+            else
+              Stat::FromStatx(statxs[index], operation.status);
+            break;
+          case Operation::kRead:
+          case Operation::kWrite:
+            if (result < 0) {
+              Fail(operation, "open()", -result);
+            } else {
+              operation.fd = result;
+              second.push_back(index);
+              closing.push_back(index);
+            }
+            break;
+        }
+      });
+
+  /* Stage 2: find the sizes of files to read, and write files. */
+  ring.Stage(second,
+      [&](struct io_uring_sqe* sqe, size_t index) {
+        Operation& operation = operations[index];
+        if (operation.type == Operation::kRead) {
+          PrepareRW(sqe, IORING_OP_STATX, operation.fd, "", STATX_SIZE,
+                    reinterpret_cast<std::uint64_t>(&statxs[index]));
+          sqe->statx_flags = AT_EMPTY_PATH;
+        } else {
+          PrepareRW(sqe, IORING_OP_WRITE, operation.fd, operation.input,
+                    std::min<size_t>(operation.input_length, 0x7ffff000), 0);
+        }
+      },
+      [&](size_t index, int result) {
+        Operation& operation = operations[index];
+        if (operation.type == Operation::kRead) {
+          size_t size = statxs[index].stx_size;
+          if (result == 0 && S_ISREG(statxs[index].stx_mode) && size != 0 &&
+              size < 0x7ffff000) {
+            operation.capacity = size + 1;
+            operation.data = base::Variant::AllocateArrayBufferData(
+                operation.capacity);
+            third.push_back(index);
+          } else {
+            /* Empty or special files (like those in /proc, whose size is
+               reported as zero) are read the ordinary way. */
+            ReadAll(operation, operation.fd, 0);
+          }
+        } else if (result < 0) {
+          Fail(operation, "write()", -result);
+        } else if (static_cast<size_t>(result) < operation.input_length) {
+          WriteRest(operation, operation.fd, result);
+        }
+      });
+
+  /* Stage 3: read files. */
+  ring.Stage(third,
+      [&](struct io_uring_sqe* sqe, size_t index) {
+        Operation& operation = operations[index];
+        PrepareRW(sqe, IORING_OP_READ, operation.fd, operation.data,
+                  operation.capacity, 0);
+      },
+      [&](size_t index, int result) {
+        Operation& operation = operations[index];
+        if (result < 0) {
+          base::Variant::FreeArrayBufferData(operation.data,
+                                             operation.capacity);
+          operation.data = NULL;
+          operation.capacity = 0;
+          Fail(operation, "read()", -result);
+          return;
+        }
+
+        operation.length = result;
+
+        /* The buffer has room for one byte more than the size reported by
+           statx(), so filling it means the file has grown since, and
+           reading less means it shrank or the read was short.  Either way,
+           read the rest the ordinary way, like the thread backend. */
+        if (operation.length == operation.capacity ||
+            operation.length < statxs[index].stx_size) {
+          if (::lseek(operation.fd, operation.length, SEEK_SET) == -1) {
+            base::Variant::FreeArrayBufferData(operation.data,
+                                               operation.capacity);
+            operation.data = NULL;
+            operation.length = 0;
+            operation.capacity = 0;
+            Fail(operation, "lseek()", errno);
+            return;
+          }
+          ReadAll(operation, operation.fd, 0);
+        }
+      });
+
+  /* Stage 4: close all files opened in stage 1, without the ring if it has
+     failed. */
+  if (ring.error()) {
+    for (auto iter(closing.begin()); iter != closing.end(); ++iter) {
+      Operation& operation = operations[*iter];
+      if (::close(operation.fd) == -1 && operation.type == Operation::kWrite &&
+          !operation.error)
+        Fail(operation, "close()", errno);
+      operation.fd = -1;
+    }
+    return true;
+  }
+
+  ring.Stage(closing,
+      [&](struct io_uring_sqe* sqe, size_t index) {
+        PrepareRW(sqe, IORING_OP_CLOSE, operations[index].fd, NULL, 0, 0);
+      },
+      [&](size_t index, int result) {
+        Operation& operation = operations[index];
+        if (result < 0 && operation.type == Operation::kWrite &&
+            !operation.error)
+          Fail(operation, "close()", -result);
+        operation.fd = -1;
+      });
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Batch::RunThreads(std::vector<Operation>& operations, unsigned threads) {
+  utilities::ThreadPool::Shared().ForEach(
+      operations.size(), threads,
+      [&operations](size_t index) { Perform(operations[index]); });
+}
+
+void Batch::Run(std::vector<Operation>& operations, Backend backend,
+                unsigned threads) {
+  if (operations.empty())
+    return;
+
+  if (backend != kThreads && RunRing(operations))
+    return;
+
+  RunThreads(operations, threads);
+}
+
+}
+}
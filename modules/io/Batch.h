@@ -0,0 +1,106 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#ifndef MODULES_IO_BATCH_H
+#define MODULES_IO_BATCH_H
+
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+namespace modules {
+namespace io {
+
+class Batch {
+ public:
+  struct Operation {
+    enum Type {
+      kRead,
+      kStat,
+      kLStat,
+      kWrite
+    };
+
+    Operation(Type type, std::string path)
+        : type(type)
+        , path(path)
+        , input(NULL)
+        , input_length(0)
+        , error(0)
+        , failed_call(NULL)
+        , data(NULL)
+        , length(0)
+        , capacity(0)
+        , fd(-1) {
+    }
+
+    Type type;
+    std::string path;
+
+    /* Data to write, for kWrite. */
+    const void* input;
+    size_t input_length;
+
+    /* Results: an errno value, or zero on success, the name of the system
+       call that failed, and the file status (for kStat and kLStat) or the
+       file contents (for kRead).  The contents are
+       allocated with base::Variant::AllocateArrayBufferData(). */
+    int error;
+    const char* failed_call;
+    struct stat status;
+    void* data;
+    size_t length;
+    size_t capacity;
+
+    int fd;
+  };
+
+  enum Backend {
+    kAutomatic,
+    kRing,
+    kThreads
+  };
+
+  static void Run(std::vector<Operation>& operations, Backend backend,
+                  unsigned threads);
+  /**< Perform all operations, submitting them together to an io_uring if
+       the kernel supports it (and 'backend' allows it), or otherwise using
+       up to 'threads' threads from the shared thread pool.  Doesn't touch
+       the isolate, so may be called from any thread.  Failures are recorded
+       per operation. */
+
+  static void Perform(Operation& operation);
+  /**< Perform a single operation on the calling thread, with ordinary
+       blocking system calls.  Doesn't touch the isolate either. */
+
+  static bool IsRingSupported();
+  /**< Return true if io_uring is available and supports the operations
+       needed. */
+
+ private:
+  static bool RunRing(std::vector<Operation>& operations);
+  static void RunThreads(std::vector<Operation>& operations, unsigned threads);
+};
+
+}
+}
+
+#endif // MODULES_IO_BATCH_H
@@ -20,96 +20,362 @@
 #include "Base.h"
 #include "modules/io/Buffered.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
+#include "base/Function.h"
+#include "base/String.h"
+#include "modules/io/File.h"
 #include "modules/io/IOError.h"
+#include "utilities/Encoding.h"
 #include "utilities/FileDescriptor.h"
 
 namespace modules {
 namespace io {
 
+/* Buffered data is kept in the range [begin, end) of a single heap buffer.
+   Consuming data only advances 'begin'; the remaining data is moved to the
+   start of the buffer when more room is needed at the end, so every byte is
+   moved at most once per refill rather than once per line.  The buffer only
+   grows when a single line doesn't fit in it. */
 class Buffered::Instance : public api::Class::Instance<Buffered> {
  public:
-  Instance(int fd);
+  Instance(int fd, size_t capacity, std::string delimiter, bool binary);
+  ~Instance();
+
+  size_t available() const { return end - begin; }
+
+  char* buffer;
+  size_t capacity;
+  size_t begin;
+  size_t end;
+
+  /* Offset, relative to 'begin', up to which the buffered data is known not
+     to contain the start of a delimiter. */
+  size_t scanned;
 
-  std::string buffer;
   int fd;
   bool eof;
+  std::string delimiter;
+  bool binary;
 };
 
-Buffered::Instance::Instance(int fd)
-    : fd(fd)
-    , eof(false) {
+Buffered::Instance::Instance(int fd, size_t capacity, std::string delimiter,
+                             bool binary)
+    : buffer(static_cast<char*>(::malloc(capacity)))
+    , capacity(capacity)
+    , begin(0)
+    , end(0)
+    , scanned(0)
+    , fd(fd)
+    , eof(false)
+    , delimiter(delimiter)
+    , binary(binary) {
+  if (!buffer)
+    throw std::bad_alloc();
+}
+
+Buffered::Instance::~Instance() {
+  ::free(buffer);
 }
 
 Buffered::Buffered()
     : api::Class("Buffered", constructor) {
   AddMethod<Buffered>("read", read);
   AddMethod<Buffered>("readln", readln);
+  AddMethod<Buffered>("readLines", readLines);
+
+  /* The iterator is written in JavaScript so that it can hand out lines one
+     at a time while fetching them from readLines() in batches, rather than
+     calling into C++ once per line. */
+  static const char kIterator[] =
+      "(function (prototype) {\n"
+      "  prototype[Symbol.iterator] = function* () {\n"
+      "    var lines;\n"
+      "    while ((lines = this.readLines({ maxLines: 1024,\n"
+      "                                     maxBytes: 65536 })).length)\n"
+      "      for (var index = 0; index < lines.length; ++index)\n"
+      "        yield lines[index];\n"
+      "  };\n"
+      "})";
+
+  v8::Handle<v8::Script> script(
+      v8::Script::Compile(base::String::New(kIterator)));
+
+  if (script.IsEmpty())
+    throw base::NestedException();
+
+  base::Function(base::Variant(script->Run()).AsObject())
+      .Call(base::Object(), { GetPrototype() });
 }
 
-Buffered::Instance* Buffered::constructor(Buffered*, base::Variant source) {
+Buffered::Instance* Buffered::constructor(Buffered*, base::Variant source,
+                                          utilities::Options options) {
   if (source.IsObject())
     source = source.AsObject().Call("fileno");
 
-  return new Instance(source.AsInt32());
+  std::string delimiter(options.GetString("delimiter", "\n"));
+  if (delimiter.empty())
+    throw base::TypeError("invalid delimiter; must not be empty");
+
+  double buffer_size = options.GetNumber("bufferSize", 65536);
+  if (buffer_size < 1 || buffer_size > std::numeric_limits<unsigned>::max())
+    throw base::RangeError("invalid buffer size");
+
+  return new Instance(source.AsInt32(), static_cast<size_t>(buffer_size),
+                      delimiter, options.GetBoolean("binary"));
 }
 
 namespace {
 
-void Fill(Buffered::Instance* instance) {
+/* Convert a line or byte limit, which must be a finite number of at least
+   one; anything else would wrap around when converted to size_t. */
+size_t GetLimit(double value) {
+  if (!(value >= 1 && std::isfinite(value)))
+    throw base::RangeError("invalid limit; must be a finite number >= 1");
+  return static_cast<size_t>(value);
+}
+
+/* Make room for more data at the end of the buffer, first by moving the
+   buffered data to the start of the buffer, and if that is not enough (the
+   buffer is full) by growing it. */
+void MakeRoom(Buffered::Instance* instance) {
+  if (instance->begin == instance->end) {
+    instance->begin = instance->end = 0;
+  } else if (instance->end == instance->capacity && instance->begin != 0) {
+    memmove(instance->buffer, instance->buffer + instance->begin,
+            instance->available());
+    instance->end -= instance->begin;
+    instance->begin = 0;
+  }
+
+  if (instance->end == instance->capacity) {
+    size_t capacity = instance->capacity * 2;
+    char* buffer = static_cast<char*>(::realloc(instance->buffer, capacity));
+    if (!buffer)
+      throw std::bad_alloc();
+    instance->buffer = buffer;
+    instance->capacity = capacity;
+  }
+}
+
+/* Read whatever is available into the buffer.  Returns false at EOF, or if
+   the file is in non-blocking mode and no data is available. */
+bool Fill(Buffered::Instance* instance) {
+  if (instance->eof)
+    return false;
+
+  MakeRoom(instance);
+
   try {
-    instance->buffer += utilities::FileDescriptor::ReadSome(instance->fd, 8172,
-							    true);
+    size_t nread = utilities::FileDescriptor::ReadInto(
+        instance->fd, instance->buffer + instance->end,
+        instance->capacity - instance->end, true);
+    instance->end += nread;
+    return nread != 0;
   } catch (utilities::FileDescriptor::EndOfFile&) {
     instance->eof = true;
+    return false;
   } catch (utilities::FileDescriptor::Error& error) {
     throw IOError("read() failed", error.errnum);
   }
 }
 
+/* Find the next delimiter in the buffered data, without rescanning data that
+   has already been searched.  Returns its offset relative to 'begin', or
+   std::string::npos if there is no complete delimiter buffered. */
+size_t FindDelimiter(Buffered::Instance* instance) {
+  const char* data = instance->buffer + instance->begin;
+  size_t length = instance->available();
+  const std::string& delimiter = instance->delimiter;
+
+  if (length < instance->scanned + delimiter.length())
+    return std::string::npos;
+
+  const char* start = data + instance->scanned;
+  const char* found;
+
+  if (delimiter.length() == 1)
+    found = static_cast<const char*>(
+        memchr(start, delimiter[0], data + length - start));
+  else
+    found = static_cast<const char*>(
+        memmem(start, data + length - start, delimiter.data(),
+               delimiter.length()));
+
+  if (found)
+    return found - data;
+
+  /* A delimiter may start within the last few bytes and be completed by the
+     next read. */
+  instance->scanned = length - (delimiter.length() - 1);
+  return std::string::npos;
+}
+
+void Consume(Buffered::Instance* instance, size_t length) {
+  instance->begin += length;
+  instance->scanned = 0;
+}
+
+base::Variant MakeLine(Buffered::Instance* instance, size_t length) {
+  const char* data = instance->buffer + instance->begin;
+
+  if (instance->binary)
+    return builtin::Bytes::FromContext()->New(data, length);
+
+  if (length > static_cast<size_t>(std::numeric_limits<int>::max()))
+    throw base::RangeError("line too long to return as a string");
+
+  if (utilities::Encoding::IsASCII(data, length))
+    return base::String::NewFromOneByte(data, length);
+  return base::String::New(data, length);
+}
+
+}
+
+bool Buffered::NextLine(Instance* instance, base::Variant& line,
+                        size_t* consumed) {
+  while (true) {
+    size_t offset = FindDelimiter(instance);
+
+    if (offset != std::string::npos) {
+      line = MakeLine(instance, offset);
+      offset += instance->delimiter.length();
+      Consume(instance, offset);
+      if (consumed)
+        *consumed = offset;
+      return true;
+    }
+
+    if (!Fill(instance)) {
+      /* Return a final line without a trailing delimiter as is, but keep a
+         partial line if more data may arrive later. */
+      if (!instance->eof || instance->available() == 0)
+        return false;
+      size_t length = instance->available();
+      line = MakeLine(instance, length);
+      Consume(instance, length);
+      if (consumed)
+        *consumed = length;
+      return true;
+    }
+  }
 }
 
 builtin::Bytes::Value Buffered::read(Instance* instance,
                                      Optional<unsigned> nbytes_opt) {
-  size_t nbytes;
-  if (nbytes_opt.specified())
-    nbytes = nbytes_opt.value();
-  else
-    nbytes = std::numeric_limits<size_t>::max();
-  while (instance->buffer.length() < nbytes && !instance->eof)
-    Fill(instance);
-  std::string result;
-  if (nbytes_opt.specified()) {
-    result = instance->buffer.substr(0, nbytes);
-    instance->buffer = instance->buffer.substr(nbytes);
-  } else {
-    result = instance->buffer;
-    instance->buffer = "";
+  builtin::Bytes* bytes = builtin::Bytes::FromContext();
+  const char* data = instance->buffer + instance->begin;
+  size_t available = instance->available();
+
+  if (!nbytes_opt.specified()) {
+    /* Read everything: return the buffered data followed by the rest of the
+       file, read in one go without passing through the buffer. */
+    builtin::Bytes::Value buffered(bytes->New(data, available));
+    Consume(instance, available);
+
+    if (instance->eof)
+      return buffered;
+
+    builtin::Bytes::Value rest(File::Read(instance->fd, 0));
+
+    /* File::Read() also stops if a non-blocking file has no more data for
+       now, so only an undefined result means end-of-file for sure. */
+    if (base::Variant(rest).IsUndefined()) {
+      instance->eof = true;
+      return buffered;
+    }
+    if (available == 0)
+      return rest;
+
+    builtin::Bytes::Value result(
+        bytes->NewUninitialized(available + rest.length()));
+    memcpy(result.data(), buffered.data(), available);
+    memcpy(static_cast<char*>(result.data()) + available, rest.data(),
+           rest.length());
+    return result;
   }
-  return builtin::Bytes::FromContext()->New(result);
-}
 
-base::Variant Buffered::readln(Instance* instance) {
-  std::string::size_type pos = 0;
+  size_t nbytes = nbytes_opt.value();
 
-  if (instance->buffer.length() == 0)
-    Fill(instance);
+  if (available >= nbytes) {
+    builtin::Bytes::Value result(bytes->New(data, nbytes));
+    Consume(instance, nbytes);
+    return result;
+  }
+
+  /* Copy what is buffered, and read the rest directly into the result. */
+  builtin::Bytes::Value result(bytes->NewUninitialized(nbytes));
+  char* target = static_cast<char*>(result.data());
+  size_t length = available;
 
-  while (pos < instance->buffer.length()) {
-    pos = instance->buffer.find("\n", pos);
+  memcpy(target, data, available);
+  Consume(instance, available);
 
-    if (pos != std::string::npos) {
-      std::string result(instance->buffer.substr(0, pos));
-      instance->buffer = instance->buffer.substr(pos + 1);
-      return base::Variant::String(result);
+  if (!instance->eof) {
+    try {
+      length += utilities::FileDescriptor::ReadInto(
+          instance->fd, target + length, nbytes - length);
+    } catch (utilities::FileDescriptor::EndOfFile&) {
+      instance->eof = true;
+    } catch (utilities::FileDescriptor::Error& error) {
+      throw IOError("read() failed", error.errnum);
     }
+  }
+
+  if (length == nbytes)
+    return result;
+  return bytes->New(target, length);
+}
 
-    pos = instance->buffer.length();
+std::vector<base::Variant> Buffered::readLines(Instance* instance,
+                                               Optional<base::Variant> limit) {
+  size_t max_lines = std::numeric_limits<size_t>::max();
+  size_t max_bytes = std::numeric_limits<size_t>::max();
 
-    Fill(instance);
+  if (limit.specified()) {
+    base::Variant value(limit.value());
+
+    if (value.IsObject()) {
+      utilities::Options options(value.AsObject());
+      if (options.Has("maxLines"))
+        max_lines = GetLimit(options.GetNumber("maxLines"));
+      if (options.Has("maxBytes"))
+        max_bytes = GetLimit(options.GetNumber("maxBytes"));
+    } else {
+      max_lines = GetLimit(value.AsNumber());
+    }
   }
 
+  std::vector<base::Variant> result;
+  size_t nbytes = 0;
+  base::Variant line;
+
+  /* Stop after the line that reaches 'max_bytes', so that a single line
+     longer than the limit is still returned. */
+  while (result.size() < max_lines && nbytes < max_bytes) {
+    size_t consumed;
+
+    if (!NextLine(instance, line, &consumed))
+      break;
+
+    result.push_back(line);
+    nbytes += consumed;
+  }
+
+  return result;
+}
+
+base::Variant Buffered::readln(Instance* instance) {
+  base::Variant line;
+
+  if (NextLine(instance, line))
+    return line;
+
   return base::Variant::Null();
 }
 
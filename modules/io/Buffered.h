@@ -33,13 +33,24 @@ class Buffered : public api::Class {
 
   Buffered();
 
+  static bool NextLine(Instance* instance, base::Variant& line,
+                       size_t* consumed = NULL);
+  /**< Set 'line' to the next line, without its delimiter, and return true, or
+       return false at EOF.  If 'consumed' is not NULL, it is set to the
+       number of bytes consumed, including the delimiter.  The final line
+       need not end with a delimiter.  If the file is in non-blocking mode,
+       false is also returned when no complete line is available yet. */
+
  private:
-  static Instance* constructor(Buffered*, base::Variant source);
+  static Instance* constructor(Buffered*, base::Variant source,
+                               utilities::Options options);
 
   static builtin::Bytes::Value read(Instance* instance,
                                     Optional<unsigned> nbytes);
 
   static base::Variant readln(Instance* instance);
+  static std::vector<base::Variant> readLines(Instance* instance,
+                                              Optional<base::Variant> limit);
 };
 
 }
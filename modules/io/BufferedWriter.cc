@@ -0,0 +1,182 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#include "Base.h"
+#include "modules/io/BufferedWriter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include <limits>
+
+#include "modules/io/IOError.h"
+#include "utilities/FileDescriptor.h"
+
+namespace modules {
+namespace io {
+
+class BufferedWriter::Instance
+    : public api::Class::Instance<BufferedWriter> {
+ public:
+  Instance(int fd, size_t capacity);
+  ~Instance();
+
+  void Write(const void* data, size_t length);
+  void Flush();
+
+  char* buffer;
+  size_t capacity;
+  size_t length;
+  int fd;
+};
+
+BufferedWriter::Instance::Instance(int fd, size_t capacity)
+    : buffer(static_cast<char*>(::malloc(capacity)))
+    , capacity(capacity)
+    , length(0)
+    , fd(fd) {
+  if (!buffer)
+    throw std::bad_alloc();
+}
+
+BufferedWriter::Instance::~Instance() {
+  /* The file descriptor belongs to someone else, and may have been closed,
+     and the number reused, by the time the writer is garbage collected, so
+     buffered data is discarded rather than written; scripts must call
+     flush() or close(). */
+  if (fd != -1 && length != 0)
+    fprintf(stderr, "WARNING: buffered writer garbage collected with "
+            "unwritten data\n");
+
+  ::free(buffer);
+}
+
+void BufferedWriter::Instance::Write(const void* data, size_t nbytes) {
+  if (fd == -1)
+    throw base::TypeError("writer closed");
+
+  if (length + nbytes <= capacity) {
+    memcpy(buffer + length, data, nbytes);
+    length += nbytes;
+    return;
+  }
+
+  /* The data doesn't fit: write the buffered data and the new data with a
+     single writev() instead of copying the new data into the buffer. */
+  struct iovec iov[2];
+
+  iov[0].iov_base = buffer;
+  iov[0].iov_len = length;
+  iov[1].iov_base = const_cast<void*>(data);
+  iov[1].iov_len = nbytes;
+
+  length = 0;
+
+  try {
+    utilities::FileDescriptor::WriteVector(fd, iov, 2);
+  } catch (utilities::FileDescriptor::Error& error) {
+    throw IOError("writev() failed", error.errnum);
+  }
+}
+
+void BufferedWriter::Instance::Flush() {
+  if (length == 0)
+    return;
+
+  size_t nbytes = length;
+  length = 0;
+
+  try {
+    utilities::FileDescriptor::Write(fd, buffer, nbytes);
+  } catch (utilities::FileDescriptor::Error& error) {
+    throw IOError("write() failed", error.errnum);
+  }
+}
+
+BufferedWriter::BufferedWriter()
+    : api::Class("BufferedWriter", constructor) {
+  AddMethod<BufferedWriter>("write", write);
+  AddMethod<BufferedWriter>("writeln", writeln);
+  AddMethod<BufferedWriter>("flush", flush);
+  AddMethod<BufferedWriter>("close", close);
+
+  AddProperty<BufferedWriter>("buffered", get_buffered);
+  AddProperty<BufferedWriter>("closed", get_closed);
+}
+
+BufferedWriter::Instance* BufferedWriter::constructor(
+    BufferedWriter*, base::Variant target, utilities::Options options) {
+  if (target.IsObject())
+    target = target.AsObject().Call("fileno");
+
+  double size = options.GetNumber("size", 65536);
+  if (size < 1 || size > std::numeric_limits<unsigned>::max())
+    throw base::RangeError("invalid buffer size");
+
+  return new Instance(target.AsInt32(), static_cast<size_t>(size));
+}
+
+void BufferedWriter::write(Instance* instance, builtin::Bytes::Value bytes) {
+  instance->Write(bytes.data(), bytes.length());
+}
+
+void BufferedWriter::writeln(Instance* instance,
+                             Optional<builtin::Bytes::Value> bytes) {
+  if (bytes.specified()) {
+    builtin::Bytes::Value value(bytes.value());
+    instance->Write(value.data(), value.length());
+  }
+
+  instance->Write("\n", 1);
+}
+
+void BufferedWriter::flush(Instance* instance) {
+  if (instance->fd == -1)
+    throw base::TypeError("writer closed");
+
+  instance->Flush();
+}
+
+void BufferedWriter::close(Instance* instance) {
+  if (instance->fd == -1)
+    throw base::TypeError("writer closed");
+
+  /* The file itself belongs to the caller and is left open. */
+  try {
+    instance->Flush();
+  } catch (...) {
+    instance->fd = -1;
+    throw;
+  }
+
+  instance->fd = -1;
+}
+
+unsigned BufferedWriter::get_buffered(Instance* instance) {
+  return instance->length;
+}
+
+bool BufferedWriter::get_closed(Instance* instance) {
+  return instance->fd == -1;
+}
+
+}
+}
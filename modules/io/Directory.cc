@@ -0,0 +1,320 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#include "modules/io/Directory.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <deque>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "utilities/Condition.h"
+#include "utilities/Mutex.h"
+#include "utilities/ThreadPool.h"
+
+namespace modules {
+namespace io {
+
+namespace {
+
+/* The kernel's record format; glibc only declares it with _GNU_SOURCE and a
+   recent enough version. */
+struct LinuxDirent64 {
+  std::uint64_t d_ino;
+  std::int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+char TypeFromMode(mode_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG: return 'f';
+    case S_IFDIR: return 'd';
+    case S_IFLNK: return 'l';
+    case S_IFIFO: return 'p';
+    case S_IFSOCK: return 's';
+    case S_IFCHR: return 'c';
+    case S_IFBLK: return 'b';
+    default: return '?';
+  }
+}
+
+char TypeFromDirent(unsigned char type) {
+  switch (type) {
+    case DT_REG: return 'f';
+    case DT_DIR: return 'd';
+    case DT_LNK: return 'l';
+    case DT_FIFO: return 'p';
+    case DT_SOCK: return 's';
+    case DT_CHR: return 'c';
+    case DT_BLK: return 'b';
+    default: return '?';
+  }
+}
+
+bool IsDot(const char* name) {
+  return name[0] == '.' &&
+      (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+}
+
+int Directory::Read(int dirfd, bool include_dots,
+                    std::vector<Entry>& entries) {
+  const size_t kBufferSize = 65536;
+  std::unique_ptr<char[]> buffer(new char[kBufferSize]);
+
+  while (true) {
+    long nread = ::syscall(SYS_getdents64, dirfd, buffer.get(), kBufferSize);
+
+    if (nread == -1) {
+      if (errno == EINTR)
+        continue;
+      return errno;
+    }
+
+    if (nread == 0)
+      return 0;
+
+    for (long offset = 0; offset < nread;) {
+      LinuxDirent64* dirent =
+          reinterpret_cast<LinuxDirent64*>(buffer.get() + offset);
+      offset += dirent->d_reclen;
+
+      if (!include_dots && IsDot(dirent->d_name))
+        continue;
+
+      Entry entry;
+      entry.name = dirent->d_name;
+      entry.type = TypeFromDirent(dirent->d_type);
+
+      if (entry.type == '?') {
+        struct stat status;
+        if (::fstatat(dirfd, dirent->d_name, &status,
+                      AT_SYMLINK_NOFOLLOW) == 0)
+          entry.type = TypeFromMode(status.st_mode);
+      }
+
+      entries.push_back(entry);
+    }
+  }
+}
+
+namespace {
+
+class Walker {
+ public:
+  Walker(int root_fd, const std::string& root,
+         const Directory::WalkOptions& options)
+      : root_fd_(root_fd)
+      , prefix_(root)
+      , options_(options)
+      , condition_(mutex_)
+      , active_(0) {
+    if (prefix_.empty() || prefix_[prefix_.length() - 1] != '/')
+      prefix_ += '/';
+  }
+
+  void Start() {
+    if (options_.follow_symlinks) {
+      struct stat status;
+      if (::fstat(root_fd_, &status) == 0)
+        Visit(status);
+    }
+
+    queue_.push_back(std::string());
+  }
+
+  /* Runs until there are no directories left to read.  Called on each
+     thread taking part in the walk. */
+  void Work(std::vector<Directory::Entry>& results);
+
+ private:
+  bool Visit(const struct stat& status) {
+    utilities::Mutex::Lock lock(visited_mutex_);
+    return visited_.insert(std::make_pair(status.st_dev,
+                                          status.st_ino)).second;
+  }
+
+  bool Matches(const std::string& relative, const std::string& name) {
+    if (options_.filters.empty())
+      return true;
+
+    for (auto iter(options_.filters.begin()); iter != options_.filters.end();
+         ++iter) {
+      if (iter->find('/') != std::string::npos) {
+        if (::fnmatch(iter->c_str(), relative.c_str(), FNM_PATHNAME) == 0)
+          return true;
+      } else if (::fnmatch(iter->c_str(), name.c_str(), 0) == 0) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void ReadDirectory(const std::string& relative,
+                     std::vector<Directory::Entry>& results,
+                     std::vector<std::string>& subdirectories);
+
+  int root_fd_;
+  std::string prefix_;
+  const Directory::WalkOptions& options_;
+
+  utilities::Mutex mutex_;
+  utilities::Condition condition_;
+  std::deque<std::string> queue_;
+  unsigned active_;
+
+  utilities::Mutex visited_mutex_;
+  std::set<std::pair<dev_t, ino_t>> visited_;
+};
+
+void Walker::ReadDirectory(const std::string& relative,
+                           std::vector<Directory::Entry>& results,
+                           std::vector<std::string>& subdirectories) {
+  int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+
+  if (!options_.follow_symlinks)
+    flags |= O_NOFOLLOW;
+
+  int fd = relative.empty() ? ::dup(root_fd_)
+                            : ::openat(root_fd_, relative.c_str(), flags);
+
+  if (fd == -1)
+    return;
+
+  std::vector<Directory::Entry> entries;
+
+  Directory::Read(fd, false, entries);
+
+  for (auto iter(entries.begin()); iter != entries.end(); ++iter) {
+    std::string path(relative.empty() ? iter->name
+                                      : relative + "/" + iter->name);
+
+    if (iter->type == 'l' && options_.follow_symlinks) {
+      struct stat status;
+      if (::fstatat(fd, iter->name.c_str(), &status, 0) == 0) {
+        iter->type = TypeFromMode(status.st_mode);
+
+        /* Don't descend into the same directory twice through links. */
+        if (iter->type == 'd' && !Visit(status)) {
+          if (Matches(path, iter->name))
+            results.push_back({ prefix_ + path, iter->type });
+          continue;
+        }
+      }
+    } else if (iter->type == 'd' && options_.follow_symlinks) {
+      struct stat status;
+      if (::fstatat(fd, iter->name.c_str(), &status,
+                    AT_SYMLINK_NOFOLLOW) == 0)
+        Visit(status);
+    }
+
+    if (iter->type == 'd')
+      subdirectories.push_back(path);
+
+    if (Matches(path, iter->name))
+      results.push_back({ prefix_ + path, iter->type });
+  }
+
+  ::close(fd);
+}
+
+void Walker::Work(std::vector<Directory::Entry>& results) {
+  std::vector<std::string> subdirectories;
+
+  while (true) {
+    std::string relative;
+
+    {
+      utilities::Condition::Lock lock(condition_);
+
+      /* Wait while other threads may still find more directories. */
+      while (queue_.empty() && active_ != 0)
+        lock.Wait();
+
+      if (queue_.empty()) {
+        lock.Broadcast();
+        return;
+      }
+
+      /* Depth first, which keeps the queue short. */
+      relative = queue_.back();
+      queue_.pop_back();
+      ++active_;
+    }
+
+    subdirectories.clear();
+    ReadDirectory(relative, results, subdirectories);
+
+    {
+      utilities::Condition::Lock lock(condition_);
+
+      queue_.insert(queue_.end(), subdirectories.rbegin(),
+                    subdirectories.rend());
+      --active_;
+
+      if (!subdirectories.empty() || active_ == 0)
+        lock.Broadcast();
+    }
+  }
+}
+
+}
+
+int Directory::Walk(const std::string& root, const WalkOptions& options,
+                    std::vector<Entry>& entries) {
+  int root_fd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if (root_fd == -1)
+    return errno;
+
+  Walker walker(root_fd, root, options);
+
+  walker.Start();
+
+  if (options.threads <= 1) {
+    walker.Work(entries);
+  } else {
+    std::vector<std::vector<Entry>> results(options.threads);
+
+    utilities::ThreadPool::Shared().ForEach(
+        options.threads, options.threads,
+        [&walker, &results](size_t index) { walker.Work(results[index]); });
+
+    for (auto iter(results.begin()); iter != results.end(); ++iter)
+      entries.insert(entries.end(), iter->begin(), iter->end());
+  }
+
+  ::close(root_fd);
+  return 0;
+}
+
+}
+}
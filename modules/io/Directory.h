@@ -0,0 +1,75 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#ifndef MODULES_IO_DIRECTORY_H
+#define MODULES_IO_DIRECTORY_H
+
+#include <string>
+#include <vector>
+
+namespace modules {
+namespace io {
+
+class Directory {
+ public:
+  struct Entry {
+    std::string name;
+    char type;
+    /**< One of 'f' (regular file), 'd' (directory), 'l' (symbolic link),
+         'p' (named pipe), 's' (socket), 'c' (character device), 'b' (block
+         device), as in find's -type, or '?' if unknown. */
+  };
+
+  static int Read(int dirfd, bool include_dots, std::vector<Entry>& entries);
+  /**< Append the entries of the open directory 'dirfd' to 'entries', using
+       getdents64() and the file type it reports.  Entries whose type the
+       file system doesn't report are stat:ed.  Returns zero, or an errno
+       value on failure.  Doesn't touch the isolate. */
+
+  struct WalkOptions {
+    WalkOptions()
+        : follow_symlinks(false)
+        , threads(1) {
+    }
+
+    std::vector<std::string> filters;
+    /**< Glob patterns; entries matching none of them are left out of the
+         result (but directories are still descended into).  Patterns
+         containing a slash are matched against the path relative to the
+         root, others against the entry's name. */
+    bool follow_symlinks;
+    unsigned threads;
+  };
+
+  static int Walk(const std::string& root, const WalkOptions& options,
+                  std::vector<Entry>& entries);
+  /**< Append all entries below 'root', with their paths (starting with
+       'root') as names.  Directories are opened relative to 'root' with
+       openat(), and read on up to 'options.threads' threads from the
+       shared thread pool, in which case the order of the entries is
+       unspecified.  Subdirectories that can't be read are skipped.  Returns
+       zero, or an errno value if 'root' can't be read.  Doesn't touch the
+       isolate. */
+};
+
+}
+}
+
+#endif // MODULES_IO_DIRECTORY_H
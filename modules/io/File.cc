@@ -21,6 +21,7 @@
 #include "modules/io/File.h"
 
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <fcntl.h>
@@ -28,16 +29,25 @@
 #include <unistd.h>
 #include <dirent.h>
 
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
 #include <memory>
 
 #include "api/GC.h"
+#include "modules/builtin/EventLoop.h"
+#include "modules/io/Batch.h"
+#include "modules/io/Directory.h"
 #include "modules/io/IOError.h"
+#include "modules/io/StatCache.h"
 #include "modules/BuiltIn.h"
 #include "modules/IO.h"
 #include "utilities/Anchor.h"
 #include "utilities/FileDescriptor.h"
 #include "utilities/File.h"
 #include "utilities/Path.h"
+#include "utilities/ThreadPool.h"
 
 namespace modules {
 namespace io {
@@ -75,6 +85,7 @@ File::File()
   AddMethod<File>("setBlocking", setBlocking);
   AddMethod<File>("setCloseOnExec", setCloseOnExec);
   AddMethod<File>("read", read);
+  AddMethod<File>("readInto", readInto);
   AddMethod<File>("write", write);
   AddMethod<File>("stat", stat);
   AddMethod<File>("close", close);
@@ -82,9 +93,14 @@ File::File()
   AddProperty<File>("closed", get_closed);
 
   AddClassFunction<File>("read", read);
+  AddClassFunction<File>("readAsync", readAsync);
+  AddClassFunction<File>("map", map);
   AddClassFunction<File>("write", write);
   AddClassFunction<File>("fdopen", fdopen);
   AddClassFunction<File>("stat", stat);
+  AddClassFunction<File>("statMany", statMany);
+  AddClassFunction<File>("setStatCache", setStatCache);
+  AddClassFunction<File>("clearStatCache", clearStatCache);
   AddClassFunction<File>("dup", dup);
   AddClassFunction<File>("dup2", dup2);
   AddClassFunction<File>("link", link);
@@ -92,11 +108,14 @@ File::File()
   AddClassFunction<File>("unlink", unlink);
   AddClassFunction<File>("chmod", chmod);
   AddClassFunction<File>("rename", rename);
+  AddClassFunction<File>("copy", copy);
   AddClassFunction<File>("chdir", chdir);
   AddClassFunction<File>("mkdir", mkdir);
   AddClassFunction<File>("utimes", utimes);
 
   AddClassFunction<File>("listDirectory", listDirectory);
+  AddClassFunction<File>("walk", walk);
+  AddClassFunction<File>("walkAsync", walkAsync);
 
   AddClassFunction<File>("isDirectory", is<S_IFDIR>);
   AddClassFunction<File>("isSocket", is<S_IFSOCK>);
@@ -111,6 +130,9 @@ File::File()
   AddClassProperty<File>("stderr", get_stderr);
 }
 
+File::~File() {
+}
+
 int File::Steal(Instance* instance) {
   int fd = instance->fd;
   instance->fd = -1;
@@ -150,6 +172,9 @@ File::Instance* File::NewInstance(std::string path, std::string mode_arg) {
   if (mode_arg == "w" || mode_arg == "w+")
     flags |= O_CREAT | O_TRUNC;
 
+  if (mode_arg != "r")
+    FromContext()->InvalidateStat(path);
+
   int fd = open(path.c_str(), flags, mode);
 
   if (fd == -1)
@@ -158,6 +183,16 @@ File::Instance* File::NewInstance(std::string path, std::string mode_arg) {
   return new Instance(fd, path, mode_arg);
 }
 
+void File::InvalidateStat(const std::string& path) {
+  if (stat_cache_)
+    stat_cache_->Invalidate(path);
+}
+
+void File::ClearStatCache() {
+  if (stat_cache_)
+    stat_cache_->Clear();
+}
+
 File::Instance* File::constructor(
     File*, std::string path, Optional<std::string> mode) {
   return NewInstance(path, mode.value("r"));
@@ -200,56 +235,194 @@ void File::setCloseOnExec(Instance* instance, bool value) {
   updateFlag(instance->fd, F_GETFD, F_SETFD, FD_CLOEXEC, value);
 }
 
-builtin::Bytes::Value File::read(Instance* instance, Optional<size_t> buflen) {
-  try {
-    std::string data;
+builtin::Bytes::Value File::Read(int fd, size_t limit) {
+  const size_t kInitialCapacity = 65536;
 
-    if (buflen.specified()) {
-      if (buflen.value() == 0)
-        throw base::TypeError("invalid argument; zero buffer length");
+  if (limit == 0)
+    limit = std::numeric_limits<size_t>::max();
 
-      data = utilities::FileDescriptor::ReadSome(instance->fd, buflen.value());
-    } else {
-      data = utilities::FileDescriptor::ReadAll(instance->fd);
-    }
+  /* For regular files, allocate room for what remains of the file plus one
+     byte, so that end-of-file is normally detected without growing the
+     buffer.  Other files start with a fixed size and grow as needed. */
+  size_t capacity = kInitialCapacity;
+  struct stat buf;
+
+  if (::fstat(fd, &buf) == 0 && S_ISREG(buf.st_mode)) {
+    off_t position = ::lseek(fd, 0, SEEK_CUR);
+    if (position != -1 && position <= buf.st_size)
+      capacity = buf.st_size - position + 1;
+  }
 
-    return builtin::Bytes::FromContext()->New(data);
+  capacity = std::min(capacity, limit);
+
+  char* data = static_cast<char*>(
+      base::Variant::AllocateArrayBufferData(capacity));
+  size_t length = 0;
+  bool eof = false;
+
+  try {
+    while (true) {
+      length += utilities::FileDescriptor::ReadInto(
+          fd, data + length, capacity - length);
+
+      if (length < capacity || capacity == limit)
+        break;
+
+      size_t new_capacity = capacity < limit / 2 ? capacity * 2 : limit;
+      char* new_data = static_cast<char*>(
+          base::Variant::AllocateArrayBufferData(new_capacity));
+      memcpy(new_data, data, length);
+      base::Variant::FreeArrayBufferData(data, capacity);
+      data = new_data;
+      capacity = new_capacity;
+    }
   } catch (utilities::FileDescriptor::EndOfFile&) {
-    return builtin::Bytes::Value();
+    eof = length == 0;
   } catch (utilities::FileDescriptor::Error& error) {
+    base::Variant::FreeArrayBufferData(data, capacity);
     throw IOError("read() failed", error.errnum);
   }
-}
 
-void File::write(Instance* instance, builtin::Bytes::Value bytes) {
-  unsigned remaining = bytes.length();
+  builtin::Bytes* bytes = builtin::Bytes::FromContext();
 
-  while (remaining) {
-    ssize_t nwritten = ::write(instance->fd, bytes.data(), remaining);
-
-    if (nwritten == -1) {
-      if (errno == EINTR)
-        continue;
-      else
-        throw IOError("write() failed", errno);
-    }
+  if (eof) {
+    base::Variant::FreeArrayBufferData(data, capacity);
+    return builtin::Bytes::Value();
+  }
 
-    remaining -= nwritten;
+  /* Don't keep a mostly unused buffer alive; copy short results instead. */
+  if (length < capacity / 2) {
+    builtin::Bytes::Value result(bytes->New(data, length));
+    base::Variant::FreeArrayBufferData(data, capacity);
+    return result;
   }
+
+  return bytes->Adopt(data, length);
 }
 
-builtin::Bytes::Value File::read(File*, std::string path) {
-  utilities::Anchor<Instance> instance(NewInstance(path, "r"));
-  std::string data;
+builtin::Bytes::Value File::read(Instance* instance, Optional<size_t> buflen) {
+  if (buflen.specified() && buflen.value() == 0)
+    throw base::TypeError("invalid argument; zero buffer length");
+
+  return Read(instance->fd, buflen.value(0));
+}
+
+std::int64_t File::readInto(Instance* instance, builtin::Bytes::Value bytes,
+                            Optional<size_t> offset_arg) {
+  size_t offset = offset_arg.value(0);
+
+  if (offset > bytes.length())
+    throw base::RangeError("offset out of range");
 
   try {
-    data = utilities::FileDescriptor::ReadAll(instance->fd);
+    return utilities::FileDescriptor::ReadInto(
+        instance->fd, static_cast<char*>(bytes.data()) + offset,
+        bytes.length() - offset);
   } catch (utilities::FileDescriptor::EndOfFile&) {
+    return 0;
   } catch (utilities::FileDescriptor::Error& error) {
     throw IOError("read() failed", error.errnum);
   }
+}
 
-  return builtin::Bytes::FromContext()->New(data);
+void File::write(Instance* instance, builtin::Bytes::Value bytes) {
+  try {
+    utilities::FileDescriptor::Write(instance->fd, bytes.data(),
+                                     bytes.length());
+  } catch (utilities::FileDescriptor::Error& error) {
+    throw IOError("write() failed", error.errnum);
+  }
+}
+
+builtin::Bytes::Value File::read(File*, std::string path) {
+  utilities::Anchor<Instance> instance(NewInstance(path, "r"));
+  builtin::Bytes::Value data(Read(instance->fd, 0));
+
+  if (base::Variant(data).IsUndefined())
+    return builtin::Bytes::FromContext()->New(static_cast<size_t>(0));
+
+  return data;
+}
+
+base::Object File::readAsync(File*, std::string path) {
+  std::shared_ptr<Batch::Operation> operation(
+      new Batch::Operation(Batch::Operation::kRead, path));
+
+  return builtin::EventLoop::FromContext()->RunInBackground(
+      [operation]() {
+        Batch::Perform(*operation);
+      },
+      [operation](builtin::EventLoop::Promise& promise) {
+        if (operation->error)
+          throw IOError(operation->failed_call + std::string(" failed"),
+                        operation->error) << " (" << operation->path << ")";
+
+        builtin::Bytes* bytes = builtin::Bytes::FromContext();
+
+        if (operation->length < operation->capacity / 2) {
+          promise.Resolve(bytes->New(operation->data, operation->length));
+          base::Variant::FreeArrayBufferData(operation->data,
+                                             operation->capacity);
+        } else {
+          promise.Resolve(bytes->Adopt(operation->data, operation->length));
+        }
+      });
+}
+
+namespace {
+
+void Unmap(void* data, size_t length) {
+  ::munmap(data, length);
+}
+
+}
+
+builtin::Bytes::Value File::map(File*, std::string path,
+                                utilities::Options options) {
+  utilities::Anchor<Instance> instance(NewInstance(path, "r"));
+  struct stat buf;
+
+  if (::fstat(instance->fd, &buf) == -1)
+    throw IOError("fstat() failed", errno) << " (" << path << ")";
+
+  size_t file_size = buf.st_size;
+  double offset_arg = options.GetNumber("offset", 0);
+
+  if (offset_arg < 0 || offset_arg > file_size)
+    throw base::RangeError("offset out of range");
+
+  size_t offset = static_cast<size_t>(offset_arg);
+  size_t length = file_size - offset;
+
+  if (options.Has("length")) {
+    double length_arg = options.GetNumber("length");
+    if (length_arg < 0 || length_arg > length)
+      throw base::RangeError("length out of range");
+    length = static_cast<size_t>(length_arg);
+  }
+
+  builtin::Bytes* bytes = builtin::Bytes::FromContext();
+
+  if (length == 0)
+    return bytes->New(static_cast<size_t>(0));
+
+  /* The mapping must start on a page boundary; the returned object is a view
+     that skips the extra leading bytes.  The mapping is private, so writes
+     through the returned object are never carried through to the file. */
+  size_t page_size = ::sysconf(_SC_PAGESIZE);
+  size_t aligned_offset = offset - offset % page_size;
+  size_t mapped_length = length + (offset - aligned_offset);
+
+  void* data = ::mmap(NULL, mapped_length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, instance->fd, aligned_offset);
+
+  if (data == MAP_FAILED)
+    throw IOError("mmap() failed", errno) << " (" << path << ")";
+
+  builtin::Bytes::Value mapping(base::Variant::MakeExternalArrayBuffer(
+      data, mapped_length, Unmap));
+
+  return bytes->View(mapping, offset - aligned_offset, length);
 }
 
 void File::write(File*, std::string path, builtin::Bytes::Value data) {
@@ -281,6 +454,9 @@ void File::close(Instance* instance) {
   if (instance->fd == -1)
     throw base::TypeError("file not open");
 
+  /* Stops watch() callbacks and rejects pending asynchronous operations. */
+  builtin::EventLoop::FromContext()->CancelWatches(instance->fd);
+
   while (true) {
     if (::close(instance->fd) == -1) {
       if (errno == EINTR)
@@ -302,12 +478,146 @@ bool File::get_closed(Instance* instance) {
 Stat::Instance* File::stat(File* module, std::string path) {
   struct stat buf;
 
-  if (::stat(path.c_str(), &buf) == -1)
+  if (module->stat_cache_) {
+    int error = module->stat_cache_->Stat(path, buf);
+    if (error)
+      throw IOError("stat() failed", error);
+  } else if (::stat(path.c_str(), &buf) == -1) {
     throw IOError("stat() failed", errno);
+  }
 
   return Stat::FromContext()->New(buf);
 }
 
+base::Object File::statMany(File* module, std::vector<std::string> paths,
+                            utilities::Options options) {
+  bool follow_symlinks = options.GetBoolean("followSymlinks", true);
+  int dirfd = AT_FDCWD;
+
+  if (options.Has("directory")) {
+    std::string directory(options.GetString("directory"));
+    dirfd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd == -1)
+      throw IOError("open() failed", errno) << " (" << directory << ")";
+  }
+
+  /* Only plain stat() results are cached, and the cache is keyed by paths
+     relative to the working directory. */
+  StatCache* cache = dirfd == AT_FDCWD && follow_symlinks
+      ? module->stat_cache_.get() : NULL;
+
+  size_t count = paths.size();
+  std::vector<double> sizes(count), mtimes(count);
+  std::vector<std::uint32_t> modes(count);
+  std::vector<std::int32_t> errors(count);
+  std::vector<size_t> misses;
+
+  auto record = [&](size_t index, const struct stat& status, int error) {
+    errors[index] = error;
+    if (!error) {
+      sizes[index] = status.st_size;
+      mtimes[index] = status.st_mtim.tv_sec * 1000.0 +
+                      status.st_mtim.tv_nsec / 1000000.0;
+      modes[index] = status.st_mode;
+    }
+  };
+
+  for (size_t index = 0; index < count; ++index) {
+    struct stat status;
+    int error;
+
+    if (cache && cache->Lookup(paths[index], status, error))
+      record(index, status, error);
+    else
+      misses.push_back(index);
+  }
+
+  std::vector<struct stat> statuses(misses.size());
+  int flags = AT_NO_AUTOMOUNT | (follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW);
+
+  /* statx() with a minimal mask lets network file systems skip fetching
+     attributes that aren't returned.  Results that go into the cache need
+     all of them, though.  Falls back to fstatat() on kernels without
+     statx(). */
+  unsigned mask = cache ? STATX_BASIC_STATS
+                        : STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME;
+
+  auto perform = [&](size_t miss) {
+    size_t index = misses[miss];
+    struct statx buffer;
+
+    if (::statx(dirfd, paths[index].c_str(), flags, mask, &buffer) == 0) {
+      Stat::FromStatx(buffer, statuses[miss]);
+      errors[index] = 0;
+    } else if (errno != ENOSYS) {
+      errors[index] = errno;
+    } else if (::fstatat(dirfd, paths[index].c_str(), &statuses[miss],
+                         follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW) == -1) {
+      errors[index] = errno;
+    } else {
+      errors[index] = 0;
+    }
+  };
+
+  unsigned threads = 1;
+
+  if (options.Has("parallel")) {
+    base::Variant parallel(options.Get("parallel"));
+    if (parallel.IsNumber())
+      threads = std::max(options.GetUInt32("parallel"), 1u);
+    else if (parallel.AsBoolean())
+      threads = std::max(::sysconf(_SC_NPROCESSORS_ONLN), 1L);
+  }
+
+  if (threads > 1) {
+    utilities::ThreadPool::Shared().ForEach(misses.size(), threads, perform);
+  } else {
+    for (size_t miss = 0; miss < misses.size(); ++miss)
+      perform(miss);
+  }
+
+  if (dirfd != AT_FDCWD)
+    ::close(dirfd);
+
+  for (size_t miss = 0; miss < misses.size(); ++miss) {
+    size_t index = misses[miss];
+
+    record(index, statuses[miss], errors[index]);
+
+    if (cache)
+      cache->Store(paths[index], statuses[miss], errors[index]);
+  }
+
+  base::Object result(base::Object::Create());
+
+  result.Put("size", base::Variant::MakeFloat64Array(
+      base::Variant::MakeArrayBuffer(sizes.data(), count * sizeof(double))));
+  result.Put("mtime", base::Variant::MakeFloat64Array(
+      base::Variant::MakeArrayBuffer(mtimes.data(), count * sizeof(double))));
+  result.Put("mode", base::Variant::MakeUint32Array(
+      base::Variant::MakeArrayBuffer(modes.data(),
+                                     count * sizeof(std::uint32_t))));
+  result.Put("error", base::Variant::MakeInt32Array(
+      base::Variant::MakeArrayBuffer(errors.data(),
+                                     count * sizeof(std::int32_t))));
+
+  return result;
+}
+
+void File::setStatCache(File* module, utilities::Options options) {
+  double ttl = options.GetNumber("ttl", 0);
+
+  if (ttl > 0)
+    module->stat_cache_.reset(new StatCache(
+        ttl, options.GetUInt32("maxEntries", 65536)));
+  else
+    module->stat_cache_.reset();
+}
+
+void File::clearStatCache(File* module) {
+  module->ClearStatCache();
+}
+
 int File::dup(File*, utilities::FileDescriptor oldfd) {
   int newfd = ::dup(oldfd);
   if (newfd == -1)
@@ -320,38 +630,63 @@ void File::dup2(File*, utilities::FileDescriptor oldfd, int newfd) {
     throw IOError("dup2() failed", errno);
 }
 
-void File::link(File*, std::string old_path, std::string new_path) {
+void File::link(File* module, std::string old_path, std::string new_path) {
+  module->InvalidateStat(old_path);
+  module->InvalidateStat(new_path);
   if (::link(old_path.c_str(), new_path.c_str()) == -1)
     throw IOError("link() failed", errno);
 }
 
-void File::symlink(File*, std::string old_path, std::string new_path) {
+void File::symlink(File* module, std::string old_path,
+                   std::string new_path) {
+  module->InvalidateStat(new_path);
   if (::symlink(old_path.c_str(), new_path.c_str()) == -1)
     throw IOError("symlink() failed", errno);
 }
 
-void File::unlink(File*, std::string path) {
+void File::unlink(File* module, std::string path) {
+  module->InvalidateStat(path);
   if (::unlink(path.c_str()) == -1)
     throw IOError("unlink() failed", errno);
 }
 
-void File::chmod(File*, std::string path, int mode) {
+void File::chmod(File* module, std::string path, int mode) {
+  module->InvalidateStat(path);
   if (::chmod(path.c_str(), mode) == -1)
     throw IOError("chmod() failed", errno);
 }
 
-void File::rename(File*, std::string old_path, std::string new_path) {
+void File::rename(File* module, std::string old_path,
+                  std::string new_path) {
+  /* Renaming a directory changes the meaning of every path below it. */
+  clearStatCache(module);
   if (::rename(old_path.c_str(), new_path.c_str()) == -1)
     throw IOError("rename() failed", errno)
         << " (" << old_path << " => " << new_path << ")";
 }
 
-void File::chdir(File*, std::string path) {
+std::int64_t File::copy(File*, std::string source_path,
+                        std::string target_path) {
+  utilities::Anchor<Instance> source(NewInstance(source_path, "r"));
+  utilities::Anchor<Instance> target(NewInstance(target_path, "w"));
+
+  try {
+    return utilities::FileDescriptor::Transfer(
+        source->fd, target->fd, std::numeric_limits<std::uint64_t>::max());
+  } catch (utilities::FileDescriptor::Error& error) {
+    throw IOError("copy failed", error.errnum)
+        << " (" << source_path << " => " << target_path << ")";
+  }
+}
+
+void File::chdir(File* module, std::string path) {
+  clearStatCache(module);
   if (::chdir(path.c_str()) == -1)
     throw IOError("chdir() failed", errno) << " (" << path << ")";
 }
 
-void File::mkdir(File*, std::string path, Optional<int> mode_arg) {
+void File::mkdir(File* module, std::string path, Optional<int> mode_arg) {
+  module->InvalidateStat(path);
   mode_t mode;
   if (mode_arg.specified())
     mode = static_cast<mode_t>(mode_arg.value());
@@ -370,8 +705,9 @@ void SetTimeval(struct timeval& tv, double time) {
 
 }
 
-void File::utimes(File*, std::string path, Optional<double> atime_opt,
+void File::utimes(File* module, std::string path, Optional<double> atime_opt,
                   Optional<double> mtime_opt) {
+  module->InvalidateStat(path);
   struct timeval times[2], *timesp = NULL;
 
   if (atime_opt.specified()) {
@@ -387,34 +723,137 @@ void File::utimes(File*, std::string path, Optional<double> atime_opt,
     throw IOError("utimes() failed", errno) << " (" << path << ")";
 }
 
-base::Object File::listDirectory(File* module, std::string path){
-  DIR* dir = ::opendir(path.c_str());
+namespace {
 
-  if (!dir)
-    throw IOError("opendir() failed", errno) << ": " << path;
+/* Return just the names, or, with types, an object with the names (under
+   'key') and a string with one type character per entry. */
+base::Object EntriesResult(const std::vector<Directory::Entry>& entries,
+                           const char* key, bool with_types) {
+  std::vector<std::string> names;
+  std::string types;
 
-  std::vector<std::string> entries;
-  struct dirent* entry;
+  names.reserve(entries.size());
+  types.reserve(entries.size());
 
-  while ((entry = ::readdir(dir)) != NULL)
-    entries.push_back(entry->d_name);
+  for (auto iter(entries.begin()); iter != entries.end(); ++iter) {
+    names.push_back(iter->name);
+    types += iter->type;
+  }
 
-  ::closedir(dir);
+  if (!with_types)
+    return base::Array::FromVector(names);
 
-  return base::Array::FromVector(entries);
+  base::Object result(base::Object::Create());
+  result.Put(key, base::Array::FromVector(names));
+  result.Put("types", base::Variant::String(types));
+  return result;
+}
+
+Directory::WalkOptions ParseWalkOptions(const utilities::Options& options) {
+  Directory::WalkOptions walk_options;
+
+  if (options.Has("filter")) {
+    base::Variant filter(options.Get("filter"));
+    if (filter.IsString())
+      walk_options.filters.push_back(filter.AsString());
+    else
+      walk_options.filters = base::Array::ToVector<std::string>(
+          filter.AsObject());
+  }
+
+  walk_options.follow_symlinks = options.GetBoolean("followSymlinks");
+
+  if (options.Has("parallel")) {
+    base::Variant parallel(options.Get("parallel"));
+    if (parallel.IsNumber())
+      walk_options.threads = std::max(options.GetUInt32("parallel"), 1u);
+    else if (parallel.AsBoolean())
+      walk_options.threads = std::max(::sysconf(_SC_NPROCESSORS_ONLN), 1L);
+  }
+
+  return walk_options;
+}
+
+}
+
+base::Object File::listDirectory(File* module, std::string path,
+                                 utilities::Options options) {
+  /* Names only includes "." and "..", like readdir() does; with types they
+     are left out. */
+  bool with_types = options.GetBoolean("withTypes");
+  int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if (fd == -1)
+    throw IOError("open() failed", errno) << ": " << path;
+
+  std::vector<Directory::Entry> entries;
+  int error = Directory::Read(fd, !with_types, entries);
+
+  ::close(fd);
+
+  if (error)
+    throw IOError("getdents64() failed", error) << ": " << path;
+
+  return EntriesResult(entries, "names", with_types);
+}
+
+base::Object File::walk(File* module, std::string root,
+                        utilities::Options options) {
+  std::vector<Directory::Entry> entries;
+  int error = Directory::Walk(root, ParseWalkOptions(options), entries);
+
+  if (error)
+    throw IOError("open() failed", error) << ": " << root;
+
+  return EntriesResult(entries, "paths", options.GetBoolean("withTypes"));
+}
+
+base::Object File::walkAsync(File* module, std::string root,
+                             utilities::Options options) {
+  struct State {
+    std::string root;
+    Directory::WalkOptions options;
+    bool with_types;
+    std::vector<Directory::Entry> entries;
+    int error;
+  };
+
+  std::shared_ptr<State> state(new State);
+
+  state->root = root;
+  state->options = ParseWalkOptions(options);
+  state->with_types = options.GetBoolean("withTypes");
+
+  return builtin::EventLoop::FromContext()->RunInBackground(
+      [state]() {
+        state->error = Directory::Walk(state->root, state->options,
+                                       state->entries);
+      },
+      [state](builtin::EventLoop::Promise& promise) {
+        if (state->error)
+          throw IOError("open() failed", state->error) << ": " << state->root;
+        promise.Resolve(EntriesResult(state->entries, "paths",
+                                      state->with_types));
+      });
 }
 
 template <unsigned Flag>
 bool File::is(File* module, std::string path) {
   struct stat buf;
+  int error = 0;
 
-  if (::stat(path.c_str(), &buf) == -1) {
-    if (errno == ENOENT || errno == ENOTDIR)
+  if (module->stat_cache_)
+    error = module->stat_cache_->Stat(path, buf);
+  else if (::stat(path.c_str(), &buf) == -1)
+    error = errno;
+
+  if (error) {
+    if (error == ENOENT || error == ENOTDIR)
       return false;
-    throw IOError("stat() failed", errno);
+    throw IOError("stat() failed", error);
   }
 
-  return (buf.st_mode & Flag) != 0;
+  return (buf.st_mode & S_IFMT) == Flag;
 }
 
 File::Instance* File::get_stdin(File* cls) {
@@ -20,27 +20,46 @@
 #ifndef MODULES_IO_FILE_H
 #define MODULES_IO_FILE_H
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "api/Class.h"
 #include "modules/io/Stat.h"
 #include "modules/builtin/Bytes.h"
 #include "utilities/FileDescriptor.h"
+#include "utilities/Options.h"
 
 namespace modules {
 namespace io {
 
+class StatCache;
+
 class File : public api::Class {
  public:
   class Instance;
 
   File();
+  ~File();
 
   static int Steal(Instance* instance);
 
+  static builtin::Bytes::Value Read(int fd, size_t limit);
+  /**< Read at most 'limit' bytes, or everything up to end-of-file if 'limit'
+       is zero, from 'fd' directly into a Bytes object, sizing the buffer from
+       fstat() when 'fd' is a regular file.  Returns an undefined value if
+       end-of-file is reached before anything is read. */
+
   Instance* New(int fd, std::string mode);
   Instance* FromObject(base::Object object);
 
   static Instance* FromObject(File* module, base::Object object);
 
+  void InvalidateStat(const std::string& path);
+  void ClearStatCache();
+  /**< Drop cached stat() results for 'path' (and its parent directory), or
+       for all paths.  No-ops unless the stat cache is enabled. */
+
   static File* FromContext(
       v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
 
@@ -56,6 +75,8 @@ class File : public api::Class {
 
   static builtin::Bytes::Value read(Instance* instance,
                                     Optional<size_t> buflen);
+  static std::int64_t readInto(Instance* instance, builtin::Bytes::Value bytes,
+                               Optional<size_t> offset);
   static void write(Instance* instance, builtin::Bytes::Value bytes);
   static Stat::Instance* stat(Instance* instance);
   static void close(Instance* instance);
@@ -63,24 +84,40 @@ class File : public api::Class {
   static bool get_closed(Instance* instance);
 
   static builtin::Bytes::Value read(File*, std::string path);
+  static base::Object readAsync(File*, std::string path);
+  static builtin::Bytes::Value map(File*, std::string path,
+                                   utilities::Options options);
   static void write(File*, std::string path, builtin::Bytes::Value bytes);
 
   static File::Instance* fdopen(File* module, utilities::FileDescriptor fd,
                                 Optional<std::string> mode);
   static Stat::Instance* stat(File* module, std::string path);
+  static base::Object statMany(File* module, std::vector<std::string> paths,
+                               utilities::Options options);
+  static void setStatCache(File* module, utilities::Options options);
+  static void clearStatCache(File* module);
   static int dup(File*, utilities::FileDescriptor fd);
   static void dup2(File*, utilities::FileDescriptor oldfd, int newfd);
-  static void link(File*, std::string old_path, std::string new_path);
-  static void symlink(File*, std::string old_path, std::string new_path);
-  static void unlink(File*, std::string path);
-  static void chmod(File*, std::string path, int mode);
-  static void rename(File*, std::string old_path, std::string new_path);
-  static void chdir(File*, std::string path);
-  static void mkdir(File*, std::string path, Optional<int> mode_arg);
-  static void utimes(File*, std::string path, Optional<double> atime,
+  static void link(File* module, std::string old_path, std::string new_path);
+  static void symlink(File* module, std::string old_path,
+                      std::string new_path);
+  static void unlink(File* module, std::string path);
+  static void chmod(File* module, std::string path, int mode);
+  static void rename(File* module, std::string old_path,
+                     std::string new_path);
+  static std::int64_t copy(File*, std::string source_path,
+                           std::string target_path);
+  static void chdir(File* module, std::string path);
+  static void mkdir(File* module, std::string path, Optional<int> mode_arg);
+  static void utimes(File* module, std::string path, Optional<double> atime,
                      Optional<double> mtime);
 
-  static base::Object listDirectory(File* module, std::string path);
+  static base::Object listDirectory(File* module, std::string path,
+                                    utilities::Options options);
+  static base::Object walk(File* module, std::string root,
+                           utilities::Options options);
+  static base::Object walkAsync(File* module, std::string root,
+                                utilities::Options options);
 
   template <unsigned Flag>
   static bool is(File* module, std::string path);
@@ -92,6 +129,8 @@ class File : public api::Class {
   base::Object::Persistent stdin;
   base::Object::Persistent stdout;
   base::Object::Persistent stderr;
+
+  std::unique_ptr<StatCache> stat_cache_;
 };
 
 }
@@ -20,9 +20,13 @@
 #include "Base.h"
 #include "modules/io/Poll.h"
 
-#include <poll.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
 
-#include <map>
+#include <limits>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "modules/io/IOError.h"
@@ -30,18 +34,61 @@
 namespace modules {
 namespace io {
 
+/* Registered file descriptors are kept in an epoll instance, so that
+   registering, modifying and unregistering are O(1) and poll() costs time
+   proportional to the number of ready file descriptors rather than to the
+   number of registered ones, as long as some are ready.
+
+   Regular files (and some other kinds of files) can't be added to an epoll
+   instance; epoll_ctl() fails with EPERM for them.  Since reading from or
+   writing to such files never blocks, they are instead treated as always
+   being ready.
+
+   The kernel silently drops file descriptors that are closed while
+   registered, where poll(2) would report them as invalid (POLLNVAL).  To
+   report them as before, all registered file descriptors are checked when
+   nothing else is ready; invalid ones are reported as ready for whatever
+   they were registered for, so that the caller's read or write fails. */
 class Poll::Instance : public api::Class::Instance<Poll> {
  public:
-  std::map<int, base::Object::Persistent> objects;
-  std::vector<struct pollfd> fds;
+  Instance(int epfd, int max_events);
+  ~Instance();
+
+  struct Entry {
+    base::Object::Persistent object;
+    std::uint32_t events;
+    bool always_ready;
+  };
+
+  typedef std::unordered_map<int, Entry> Entries;
+
+  Entries entries;
+  std::set<int> always_ready;
+  std::set<int> invalid;
+  int epfd;
+
+  /* The result of the last call to poll(). */
+  std::vector<struct epoll_event> ready;
+  int nready;
 
   base::Object::Persistent read;
   base::Object::Persistent write;
 };
 
+Poll::Instance::Instance(int epfd, int max_events)
+    : epfd(epfd)
+    , ready(max_events)
+    , nready(0) {
+}
+
+Poll::Instance::~Instance() {
+  ::close(epfd);
+}
+
 Poll::Poll()
     : api::Class("Poll", &constructor) {
   AddMethod<Poll>("register", &register_);
+  AddMethod<Poll>("modify", &modify);
   AddMethod<Poll>("unregister", &unregister);
   AddMethod<Poll>("poll", &poll);
   AddMethod<Poll>("isEmpty", &isEmpty);
@@ -51,16 +98,19 @@ Poll::Poll()
   AddProperty<Poll>("write", &get_write);
 }
 
-Poll::Instance* Poll::constructor(Poll*) {
-  return new Instance;
-}
+namespace {
 
-void Poll::register_(Instance* instance, base::Variant file,
-                     Optional<std::string> mode_opt) {
-  base::Object::Persistent object;
+int CreateEpoll() {
+  int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epfd == -1)
+    throw IOError("epoll_create1() failed", errno);
+  return epfd;
+}
 
+int GetFileno(base::Variant& file, base::Object::Persistent* object) {
   if (file.IsObject()) {
-    object = file.AsObject();
+    if (object)
+      *object = file.AsObject();
     file = file.AsObject().Call("fileno");
   }
 
@@ -69,117 +119,239 @@ void Poll::register_(Instance* instance, base::Variant file,
   if (fileno < 0)
     throw IOError("invalid file descriptor");
 
-  if (instance->objects.find(fileno) != instance->objects.end())
-    throw IOError("file descriptor already registered");
+  return fileno;
+}
 
-  short events;
+std::uint32_t GetEvents(const Optional<std::string>& mode_opt,
+                        const utilities::Options& options) {
+  std::uint32_t events;
 
   if (mode_opt.specified()) {
     if (mode_opt.value() == "read")
-      events = POLLIN;
+      events = EPOLLIN;
     else if (mode_opt.value() == "write")
-      events = POLLOUT;
+      events = EPOLLOUT;
     else if (mode_opt.value() == "both")
-      events = POLLIN | POLLOUT;
+      events = EPOLLIN | EPOLLOUT;
     else
       throw IOError("invalid mode argument: ") << mode_opt.value();
   } else {
-    events = POLLIN | POLLOUT;
+    events = EPOLLIN | EPOLLOUT;
   }
 
-  struct pollfd fd;
+  if (options.GetBoolean("edgeTriggered"))
+    events |= EPOLLET;
 
-  fd.fd = fileno;
-  fd.events = events;
-  fd.revents = 0;
-
-  instance->fds.push_back(fd);
-  instance->objects.insert(std::make_pair(fileno, object));
+  return events;
 }
 
-void Poll::unregister(Instance* instance, base::Variant file) {
-  base::Object::Persistent object;
+/* Add, modify or delete 'fd' in the epoll instance.  Returns false if the
+   file descriptor doesn't support epoll, meaning it is always ready. */
+bool Control(Poll::Instance* instance, int op, int fd, std::uint32_t events) {
+  struct epoll_event event;
 
-  if (file.IsObject()) {
-    object = file.AsObject();
-    file = file.AsObject().Call("fileno");
+  event.events = events;
+  event.data.fd = fd;
+
+  if (::epoll_ctl(instance->epfd, op, fd, &event) == -1) {
+    if (errno == EPERM)
+      return false;
+    throw IOError("epoll_ctl() failed", errno);
   }
 
-  int fileno = file.AsInt32();
+  return true;
+}
 
-  if (fileno < 0)
-    throw IOError("invalid file descriptor");
+int Wait(Poll::Instance* instance, int timeout) {
+  int result = ::epoll_wait(instance->epfd, instance->ready.data(),
+                            instance->ready.size(), timeout);
 
-  if (instance->objects.erase(fileno) == 0)
-    throw IOError("file descriptor not registered");
+  if (result == -1)
+    throw IOError("epoll_wait() failed", errno);
 
-  std::vector<struct pollfd>::iterator iter(instance->fds.begin());
-  while (iter->fd != fileno)
-    ++iter;
-  instance->fds.erase(iter);
+  return result;
+}
+
+void FindInvalid(Poll::Instance* instance) {
+  for (Poll::Instance::Entries::const_iterator iter(instance->entries.begin());
+       iter != instance->entries.end();
+       ++iter)
+    if (!iter->second.always_ready &&
+        ::fcntl(iter->first, F_GETFD) == -1 && errno == EBADF)
+      instance->invalid.insert(iter->first);
+}
 
+void ForgetResult(Poll::Instance* instance) {
+  instance->nready = 0;
+  instance->invalid.clear();
   instance->read.Release();
   instance->write.Release();
 }
 
+}
+
+Poll::Instance* Poll::constructor(Poll*, utilities::Options options) {
+  double max_events = options.GetNumber("maxEvents", 1024);
+  int limit = std::numeric_limits<int>::max() / sizeof(struct epoll_event);
+
+  if (!(max_events >= 1 && max_events <= limit))
+    throw base::RangeError("invalid maxEvents; must be between 1 and " +
+                           std::to_string(limit));
+
+  return new Instance(CreateEpoll(), static_cast<int>(max_events));
+}
+
+void Poll::register_(Instance* instance, base::Variant file,
+                     Optional<std::string> mode_opt,
+                     utilities::Options options) {
+  Instance::Entry entry;
+  int fileno = GetFileno(file, &entry.object);
+
+  if (instance->entries.find(fileno) != instance->entries.end())
+    throw IOError("file descriptor already registered");
+
+  entry.events = GetEvents(mode_opt, options);
+  entry.always_ready = !Control(instance, EPOLL_CTL_ADD, fileno, entry.events);
+
+  if (entry.always_ready)
+    instance->always_ready.insert(fileno);
+
+  instance->entries.insert(std::make_pair(fileno, entry));
+}
+
+void Poll::modify(Instance* instance, base::Variant file,
+                  Optional<std::string> mode_opt, utilities::Options options) {
+  int fileno = GetFileno(file, NULL);
+  Instance::Entries::iterator iter(instance->entries.find(fileno));
+
+  if (iter == instance->entries.end())
+    throw IOError("file descriptor not registered");
+
+  iter->second.events = GetEvents(mode_opt, options);
+
+  if (!iter->second.always_ready)
+    Control(instance, EPOLL_CTL_MOD, fileno, iter->second.events);
+
+  ForgetResult(instance);
+}
+
+void Poll::unregister(Instance* instance, base::Variant file) {
+  int fileno = GetFileno(file, NULL);
+  Instance::Entries::iterator iter(instance->entries.find(fileno));
+
+  if (iter == instance->entries.end())
+    throw IOError("file descriptor not registered");
+
+  /* The file descriptor may already have been closed, in which case the
+     kernel has removed it from the epoll instance already. */
+  if (iter->second.always_ready)
+    instance->always_ready.erase(fileno);
+  else if (::epoll_ctl(instance->epfd, EPOLL_CTL_DEL, fileno, NULL) == -1 &&
+           errno != EBADF && errno != ENOENT)
+    throw IOError("epoll_ctl() failed", errno);
+
+  instance->entries.erase(iter);
+
+  ForgetResult(instance);
+}
+
 bool Poll::poll(Instance* instance, Optional<int> timeout_opt) {
-  instance->read.Release();
-  instance->write.Release();
+  ForgetResult(instance);
 
   int timeout;
 
-  if (timeout_opt.specified())
+  if (!instance->always_ready.empty())
+    timeout = 0;
+  else if (timeout_opt.specified())
     timeout = timeout_opt.value();
   else
     timeout = -1;
 
-  int result = ::poll(instance->fds.data(), instance->fds.size(), timeout);
+  /* Check without blocking first, so that invalid file descriptors are found
+     before waiting for events that will never come. */
+  int result = Wait(instance, 0);
 
-  if (result == 0)
-    return false;
-  else if (result == -1)
-    throw IOError("poll() failed", errno);
+  if (result == 0) {
+    FindInvalid(instance);
 
-  return true;
+    if (timeout != 0 && instance->invalid.empty())
+      result = Wait(instance, timeout);
+  }
+
+  instance->nready = result;
+
+  return result != 0 || !instance->always_ready.empty() ||
+         !instance->invalid.empty();
 }
 
 bool Poll::isEmpty(Instance* instance) {
-  return instance->fds.size() == 0;
+  return instance->entries.empty();
 }
 
 void Poll::clear(Instance* instance) {
-  instance->objects.clear();
-  instance->fds.clear();
+  /* Replacing the epoll instance is cheaper than removing every file
+     descriptor from it. */
+  int epfd = CreateEpoll();
+  ::close(instance->epfd);
+  instance->epfd = epfd;
 
-  instance->read.Release();
-  instance->write.Release();
+  instance->entries.clear();
+  instance->always_ready.clear();
+
+  ForgetResult(instance);
 }
 
 base::Object Poll::get_read(Instance* instance) {
   if (instance->read.IsEmpty())
-    instance->read = GetMatching(instance, POLLIN);
+    instance->read = GetMatching(instance, EPOLLIN);
   return instance->read.GetObject();
 }
 
 base::Object Poll::get_write(Instance* instance) {
   if (instance->write.IsEmpty())
-    instance->write = GetMatching(instance, POLLOUT);
+    instance->write = GetMatching(instance, EPOLLOUT);
   return instance->write.GetObject();
 }
 
 base::Object Poll::GetMatching(Instance* instance, int mask) {
   std::vector<base::Variant> values;
 
-  for (std::vector<struct pollfd>::iterator iter = instance->fds.begin();
-       iter != instance->fds.end();
-       ++iter) {
-    if ((iter->events & mask) != 0 && iter->revents != 0) {
-      base::Object object(instance->objects.find(iter->fd)->second.GetObject());
-      if (object.IsEmpty())
-        values.push_back(base::Variant::Int32(iter->fd));
-      else
-        values.push_back(base::Variant::Object(object));
-    }
+  /* Errors and hang-ups are reported both as readable and as writable, so
+     that the caller's subsequent read or write reports them. */
+  std::uint32_t matching = mask | EPOLLERR | EPOLLHUP;
+
+  auto add = [&values](int fd, const Instance::Entry& entry) {
+    base::Object object(entry.object.GetObject());
+    if (object.IsEmpty())
+      values.push_back(base::Variant::Int32(fd));
+    else
+      values.push_back(base::Variant::Object(object));
+  };
+
+  for (int index = 0; index < instance->nready; ++index) {
+    const struct epoll_event& event = instance->ready[index];
+    Instance::Entries::const_iterator iter(
+        instance->entries.find(event.data.fd));
+
+    if (iter != instance->entries.end() && (iter->second.events & mask) != 0 &&
+        (event.events & matching) != 0)
+      add(event.data.fd, iter->second);
+  }
+
+  for (std::set<int>::const_iterator fd(instance->always_ready.begin());
+       fd != instance->always_ready.end();
+       ++fd) {
+    const Instance::Entry& entry(instance->entries.find(*fd)->second);
+    if ((entry.events & mask) != 0)
+      add(*fd, entry);
+  }
+
+  for (std::set<int>::const_iterator fd(instance->invalid.begin());
+       fd != instance->invalid.end();
+       ++fd) {
+    const Instance::Entry& entry(instance->entries.find(*fd)->second);
+    if ((entry.events & mask) != 0)
+      add(*fd, entry);
   }
 
   return base::Array::FromVector(values);
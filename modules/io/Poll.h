@@ -21,6 +21,7 @@
 #define MODULES_IO_POLL_H
 
 #include "api/Class.h"
+#include "utilities/Options.h"
 
 namespace modules {
 namespace io {
@@ -35,10 +36,13 @@ class Poll : public api::Class {
       v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
 
  private:
-  static Instance* constructor(Poll*);
+  static Instance* constructor(Poll*, utilities::Options options);
 
   static void register_(Instance* instance, base::Variant file,
-                        Optional<std::string> mode);
+                        Optional<std::string> mode,
+                        utilities::Options options);
+  static void modify(Instance* instance, base::Variant file,
+                     Optional<std::string> mode, utilities::Options options);
   static void unregister(Instance* instance, base::Variant file);
   static bool poll(Instance* instance, Optional<int> timeout);
   static bool isEmpty(Instance* instance);
@@ -22,13 +22,17 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <unistd.h>
 
-#include <memory>
 #include <cstring>
+#include <limits>
 
 #include "modules/IO.h"
+#include "modules/builtin/EventLoop.h"
 #include "modules/io/IOError.h"
 
 namespace modules {
@@ -82,6 +86,11 @@ Socket::Socket()
   AddMethod<Socket>("recvfd", recvfd);
   AddMethod<Socket>("send", send);
   AddMethod<Socket>("sendfd", sendfd);
+  AddMethod<Socket>("sendFile", sendFile);
+  AddMethod<Socket>("acceptAsync", acceptAsync);
+  AddMethod<Socket>("connectAsync", connectAsync);
+  AddMethod<Socket>("recvAsync", recvAsync);
+  AddMethod<Socket>("sendAsync", sendAsync);
   AddMethod<Socket>("shutdown", shutdown);
   AddMethod<Socket>("close", close);
 
@@ -231,8 +240,13 @@ builtin::Bytes::Value Socket::recv(Socket::Instance* instance,
   else if (buflen == 0)
     throw IOError("zero buffer length specified");
 
-  std::unique_ptr<char[]> buffer(new char[buflen]);
-  ssize_t retval = ::recv(instance->fd, buffer.get(), buflen, 0);
+  builtin::Bytes* bytes = builtin::Bytes::FromContext();
+  builtin::Bytes::Value buffer(bytes->NewUninitialized(buflen));
+  ssize_t retval;
+
+  do
+    retval = ::recv(instance->fd, buffer.data(), buflen, 0);
+  while (retval == -1 && errno == EINTR);
 
   if (retval == 0)
     return builtin::Bytes::Value();
@@ -244,7 +258,14 @@ builtin::Bytes::Value Socket::recv(Socket::Instance* instance,
       throw IOError("recv() failed", errno);
   }
 
-  return builtin::Bytes::FromContext()->New(std::string(buffer.get(), retval));
+  if (static_cast<size_t>(retval) == buflen)
+    return buffer;
+
+  /* Short read: don't keep a mostly unused buffer alive. */
+  if (static_cast<size_t>(retval) < buflen / 2)
+    return bytes->New(buffer.data(), retval);
+
+  return bytes->View(buffer, 0, retval);
 }
 
 int Socket::recvfd(Instance* instance) {
@@ -313,6 +334,214 @@ std::int64_t Socket::send(Socket::Instance* instance, builtin::Bytes::Value byte
   return sent;
 }
 
+namespace {
+
+/* Unlike send(), sendfile() and splice() have no MSG_NOSIGNAL flag, so
+   block SIGPIPE while they run and discard it if it was raised. */
+class BlockSIGPIPE {
+ public:
+  BlockSIGPIPE() {
+    sigset_t pending;
+    sigemptyset(&sigpipe_);
+    sigaddset(&sigpipe_, SIGPIPE);
+    sigpending(&pending);
+    was_pending_ = sigismember(&pending, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe_, &old_mask_);
+  }
+
+  ~BlockSIGPIPE() {
+    if (!was_pending_) {
+      sigset_t pending;
+      sigpending(&pending);
+      if (sigismember(&pending, SIGPIPE)) {
+        struct timespec timeout = { 0, 0 };
+        sigtimedwait(&sigpipe_, NULL, &timeout);
+      }
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask_, NULL);
+  }
+
+ private:
+  sigset_t sigpipe_;
+  sigset_t old_mask_;
+  bool was_pending_;
+};
+
+}
+
+std::int64_t Socket::sendFile(Instance* instance,
+                              utilities::FileDescriptor file,
+                              Optional<std::int64_t> offset_arg,
+                              Optional<std::int64_t> length_arg) {
+  if (!instance->connected)
+    throw IOError("socket not connected");
+  if (offset_arg.specified() && offset_arg.value() < 0)
+    throw base::RangeError("invalid offset; must be non-negative");
+  if (length_arg.specified() && length_arg.value() < 0)
+    throw base::RangeError("invalid length; must be non-negative");
+
+  std::int64_t offset = offset_arg.value(0);
+  std::uint64_t length = std::numeric_limits<std::uint64_t>::max();
+
+  if (length_arg.specified())
+    length = length_arg.value();
+
+  BlockSIGPIPE block_sigpipe;
+
+  try {
+    return utilities::FileDescriptor::Transfer(
+        file, instance->fd, length, offset_arg.specified() ? &offset : NULL);
+  } catch (utilities::FileDescriptor::Error& error) {
+    throw IOError("sendfile() failed", error.errnum);
+  }
+}
+
+/* The asynchronous variants wait for the socket to become ready using the
+   event loop, and then perform the same operation as their synchronous
+   counterparts, which no longer blocks at that point.  Since a socket can
+   have several operations pending, one may find that another has already
+   consumed what made the socket ready, and then waits again. */
+
+namespace {
+
+bool IsReadable(int fd) {
+  struct pollfd pfd;
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+
+  int retval;
+  do
+    retval = ::poll(&pfd, 1, 0);
+  while (retval == -1 && errno == EINTR);
+
+  return retval != 0;
+}
+
+}
+
+base::Object Socket::acceptAsync(Instance* instance) {
+  if (instance->connected)
+    throw IOError("socket already connected");
+  else if (!instance->listening)
+    throw IOError("socket not listening");
+
+  return builtin::EventLoop::FromContext()->WhenReady(
+      instance->fd, EPOLLIN,
+      [instance](builtin::EventLoop::Promise& promise) {
+        if (!IsReadable(instance->fd))
+          return false;
+        promise.Resolve(accept(instance)->GetObject());
+        return true;
+      },
+      instance->GetObject());
+}
+
+base::Object Socket::connectAsync(Instance* instance,
+                                  SocketAddress::Instance* address) {
+  if (instance->connected)
+    throw IOError("socket already connected");
+  else if (instance->listening)
+    throw IOError("socket already listening");
+  else if (!SocketAddress::is_valid(address))
+    throw IOError("invalid address");
+  else if (SocketAddress::family(address) != instance->domain)
+    throw IOError("wrong address type");
+
+  int flags = ::fcntl(instance->fd, F_GETFL);
+
+  if (flags == -1 || ::fcntl(instance->fd, F_SETFL, flags | O_NONBLOCK) == -1)
+    throw IOError("fcntl() failed", errno);
+
+  int retval = ::connect(instance->fd, SocketAddress::addr(address),
+                         SocketAddress::addrlen(address));
+  int error = retval == -1 ? errno : 0;
+
+  if (error != EINPROGRESS)
+    ::fcntl(instance->fd, F_SETFL, flags);
+
+  if (error != 0 && error != EINPROGRESS)
+    throw IOError("connect() failed", error);
+
+  /* Connected straight away (typically UNIX sockets) or in progress; either
+     way, the socket is writable once the outcome is known. */
+  return builtin::EventLoop::FromContext()->WhenReady(
+      instance->fd, EPOLLOUT,
+      [instance, flags, error](builtin::EventLoop::Promise& promise) {
+        int result = 0;
+
+        if (error == EINPROGRESS) {
+          socklen_t length = sizeof result;
+          ::getsockopt(instance->fd, SOL_SOCKET, SO_ERROR, &result, &length);
+          ::fcntl(instance->fd, F_SETFL, flags);
+        }
+
+        if (result != 0)
+          throw IOError("connect() failed", result);
+
+        instance->connected = true;
+        promise.Resolve(base::Variant::Undefined());
+        return true;
+      },
+      instance->GetObject());
+}
+
+base::Object Socket::recvAsync(Instance* instance, unsigned buflen) {
+  if (!instance->connected)
+    throw IOError("socket not connected");
+  else if (buflen == 0)
+    throw IOError("zero buffer length specified");
+
+  return builtin::EventLoop::FromContext()->WhenReady(
+      instance->fd, EPOLLIN,
+      [instance, buflen](builtin::EventLoop::Promise& promise) {
+        if (!IsReadable(instance->fd))
+          return false;
+        promise.Resolve(recv(instance, buflen));
+        return true;
+      },
+      instance->GetObject());
+}
+
+base::Object Socket::sendAsync(Instance* instance,
+                               builtin::Bytes::Value bytes) {
+  if (!instance->connected)
+    throw IOError("socket not connected");
+
+  /* The data must stay alive, and can only be referenced through a
+     persistent handle, for as long as the operation is pending. */
+  base::Object::Persistent data(base::Variant(bytes).AsObject());
+  std::shared_ptr<size_t> sent(new size_t(0));
+
+  return builtin::EventLoop::FromContext()->WhenReady(
+      instance->fd, EPOLLOUT,
+      [instance, data, sent](builtin::EventLoop::Promise& promise) {
+        builtin::Bytes::Value bytes(base::Variant(data.GetObject()));
+        const char* buffer = static_cast<const char*>(bytes.data());
+        size_t length = bytes.length();
+
+        while (*sent < length) {
+          ssize_t retval = ::send(instance->fd, buffer + *sent,
+                                  length - *sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+          if (retval == -1) {
+            if (errno == EINTR)
+              continue;
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+              return false;
+            else
+              throw IOError("send() failed", errno);
+          }
+
+          *sent += retval;
+        }
+
+        promise.Resolve(base::Variant::Integer(*sent));
+        return true;
+      },
+      instance->GetObject());
+}
+
 void Socket::sendfd(Instance* instance, base::Variant fd_arg) {
   if (instance->domain != AF_UNIX)
     throw IOError("sendfd() only available on UNIX sockets");
@@ -379,6 +608,9 @@ void Socket::close(Socket::Instance* instance) {
   if (instance->fd == -1)
     throw IOError("socket already closed");
 
+  /* Rejects pending asynchronous operations. */
+  builtin::EventLoop::FromContext()->CancelWatches(instance->fd);
+
   while (true) {
     if (::close(instance->fd) == -1) {
       if (errno == EINTR)
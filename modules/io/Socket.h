@@ -24,6 +24,7 @@
 
 #include "modules/io/SocketAddress.h"
 #include "modules/builtin/Bytes.h"
+#include "utilities/FileDescriptor.h"
 
 namespace modules {
 namespace io {
@@ -57,6 +58,17 @@ class Socket : public api::Class {
   static int recvfd(Instance* instance);
   static std::int64_t send(Instance* instance, builtin::Bytes::Value bytes);
   static void sendfd(Instance* instance, base::Variant fd);
+  static std::int64_t sendFile(Instance* instance,
+                               utilities::FileDescriptor file,
+                               Optional<std::int64_t> offset,
+                               Optional<std::int64_t> length);
+  static base::Object acceptAsync(Instance* instance);
+  static base::Object connectAsync(Instance* instance,
+                                   SocketAddress::Instance* address);
+  static base::Object recvAsync(Instance* instance, unsigned buflen);
+  static base::Object sendAsync(Instance* instance,
+                                builtin::Bytes::Value bytes);
+
   static void shutdown(Instance* instance, std::string how);
   static void close(Instance* instance);
 
@@ -29,6 +29,7 @@
 #include <memory>
 
 #include "modules/IO.h"
+#include "modules/builtin/EventLoop.h"
 #include "modules/io/IOError.h"
 
 namespace modules {
@@ -95,6 +96,8 @@ SocketAddress::SocketAddress()
   AddClassFunction<SocketAddress>("unix", &unix);
   AddClassFunction<SocketAddress>("internet", &internet);
   AddClassFunction<SocketAddress>("internet6", &internet6);
+  AddClassFunction<SocketAddress>("internetAsync", &internetAsync);
+  AddClassFunction<SocketAddress>("internet6Async", &internet6Async);
 }
 
 bool SocketAddress::is_valid(SocketAddress::Instance* instance) {
@@ -159,30 +162,30 @@ SocketAddress::Instance* SocketAddress::unix(
 
 namespace {
 
-SocketAddress::Instance* internet_common(SocketAddress* cls, int family,
-                                         Optional<std::string> host,
-                                         Optional<base::Variant> service_arg) {
-  struct addrinfo hints;
-
-  hints.ai_flags = AI_PASSIVE;
-  hints.ai_family = family;
-  hints.ai_socktype = 0;
-  hints.ai_protocol = 0;
-
+std::string ServiceString(Optional<base::Variant> service_arg) {
   base::Variant service(service_arg.value(base::Variant::UInt32(0)));
 
   if (service.IsNumber())
     service = service.ToUInt32();
 
-  struct addrinfo *addrinfo = NULL;
-  const char *host_string = host.specified() ? host.value().c_str() : NULL;
-  const char *service_string = service.AsString().c_str();
+  return service.AsString();
+}
 
-  int errcode = getaddrinfo(host_string, service_string, &hints, &addrinfo);
+int Resolve(int family, Optional<std::string> host, std::string service,
+            struct addrinfo** addrinfo) {
+  struct addrinfo hints;
 
-  if (errcode != 0)
-    throw IOError("getaddrinfo() failed: ") << gai_strerror(errcode);
+  memset(&hints, 0, sizeof hints);
+  hints.ai_flags = AI_PASSIVE;
+  hints.ai_family = family;
 
+  const char *host_string = host.specified() ? host.value().c_str() : NULL;
+
+  return getaddrinfo(host_string, service.c_str(), &hints, addrinfo);
+}
+
+SocketAddress::Instance* NewInternet(SocketAddress* cls, int family,
+                                     struct addrinfo* addrinfo) {
   SocketAddress::Instance* instance = new SocketAddress::Instance;
 
   if (family == AF_INET)
@@ -198,6 +201,51 @@ SocketAddress::Instance* internet_common(SocketAddress* cls, int family,
   return instance;
 }
 
+SocketAddress::Instance* internet_common(SocketAddress* cls, int family,
+                                         Optional<std::string> host,
+                                         Optional<base::Variant> service) {
+  struct addrinfo *addrinfo = NULL;
+  int errcode = Resolve(family, host, ServiceString(service), &addrinfo);
+
+  if (errcode != 0)
+    throw IOError("getaddrinfo() failed: ") << gai_strerror(errcode);
+
+  return NewInternet(cls, family, addrinfo);
+}
+
+base::Object internet_async(SocketAddress* cls, int family,
+                            Optional<std::string> host,
+                            Optional<base::Variant> service) {
+  /* getaddrinfo() may block for a long time on DNS lookups, so it is run on
+     the thread pool. */
+  struct State {
+    Optional<std::string> host;
+    std::string service;
+    struct addrinfo* addrinfo;
+    int errcode;
+  };
+
+  std::shared_ptr<State> state(new State);
+
+  state->host = host;
+  state->service = ServiceString(service);
+  state->addrinfo = NULL;
+
+  return builtin::EventLoop::FromContext()->RunInBackground(
+      [state, family]() {
+        state->errcode = Resolve(family, state->host, state->service,
+                                 &state->addrinfo);
+      },
+      [state, cls, family](builtin::EventLoop::Promise& promise) {
+        if (state->errcode != 0)
+          throw IOError("getaddrinfo() failed: ")
+              << gai_strerror(state->errcode);
+
+        promise.Resolve(base::AsResult(
+            NewInternet(cls, family, state->addrinfo)));
+      });
+}
+
 }
 
 SocketAddress::Instance* SocketAddress::internet(
@@ -212,6 +260,18 @@ SocketAddress::Instance* SocketAddress::internet6(
   return internet_common(cls, AF_INET6, host, service);
 }
 
+base::Object SocketAddress::internetAsync(
+    SocketAddress* cls, Optional<std::string> host,
+    Optional<base::Variant> service) {
+  return internet_async(cls, AF_INET, host, service);
+}
+
+base::Object SocketAddress::internet6Async(
+    SocketAddress* cls, Optional<std::string> host,
+    Optional<base::Variant> service) {
+  return internet_async(cls, AF_INET6, host, service);
+}
+
 std::string SocketAddress::get_family(Instance* instance) {
   switch (instance->type) {
     case Instance::Type::kUnix:
@@ -54,6 +54,11 @@ class SocketAddress : public api::Class {
                             Optional<base::Variant> service);
   static Instance* internet6(SocketAddress*, Optional<std::string> host,
                              Optional<base::Variant> service);
+  static base::Object internetAsync(SocketAddress*, Optional<std::string> host,
+                                    Optional<base::Variant> service);
+  static base::Object internet6Async(SocketAddress*,
+                                     Optional<std::string> host,
+                                     Optional<base::Variant> service);
 
   static std::string get_family(Instance* instance);
   static std::string get_unix(Instance* instance);
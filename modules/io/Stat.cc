@@ -20,6 +20,9 @@
 #include "Base.h"
 #include "modules/io/Stat.h"
 
+#include <string.h>
+#include <sys/sysmacros.h>
+
 #include "modules/IO.h"
 
 namespace modules {
@@ -65,13 +68,33 @@ Stat::Instance* Stat::New(const struct stat& buf) {
   return instance;
 }
 
+void Stat::FromStatx(const struct statx& source, struct stat& target) {
+  memset(&target, 0, sizeof target);
+  target.st_dev = makedev(source.stx_dev_major, source.stx_dev_minor);
+  target.st_ino = source.stx_ino;
+  target.st_mode = source.stx_mode;
+  target.st_nlink = source.stx_nlink;
+  target.st_uid = source.stx_uid;
+  target.st_gid = source.stx_gid;
+  target.st_rdev = makedev(source.stx_rdev_major, source.stx_rdev_minor);
+  target.st_size = source.stx_size;
+  target.st_blksize = source.stx_blksize;
+  target.st_blocks = source.stx_blocks;
+  target.st_atim.tv_sec = source.stx_atime.tv_sec;
+  target.st_atim.tv_nsec = source.stx_atime.tv_nsec;
+  target.st_mtim.tv_sec = source.stx_mtime.tv_sec;
+  target.st_mtim.tv_nsec = source.stx_mtime.tv_nsec;
+  target.st_ctim.tv_sec = source.stx_ctime.tv_sec;
+  target.st_ctim.tv_nsec = source.stx_ctime.tv_nsec;
+}
+
 Stat* Stat::FromContext(v8::Handle<v8::Context> context) {
   return IO::FromContext(context)->stat();
 }
 
 template <unsigned Flag>
 bool Stat::is(Instance* instance) {
-  return (instance->buf.st_mode & Flag) != 0;
+  return (instance->buf.st_mode & S_IFMT) == Flag;
 }
 
 std::int64_t Stat::get_dev(Instance* instance) {
@@ -99,7 +122,7 @@ std::int64_t Stat::get_gid(Instance* instance) {
 }
 
 std::int64_t Stat::get_rdev(Instance* instance) {
-  return instance->buf.st_gid;
+  return instance->buf.st_rdev;
 }
 
 std::int64_t Stat::get_size(Instance* instance) {
@@ -25,6 +25,8 @@
 
 #include "api/Class.h"
 
+struct statx;
+
 namespace modules {
 namespace io {
 
@@ -36,6 +38,10 @@ class Stat : public api::Class {
 
   Instance* New(const struct stat& data);
 
+  static void FromStatx(const struct statx& source, struct stat& target);
+  /**< Convert statx() output to a struct stat.  Fields not returned by
+       statx() are zero. */
+
   static Stat* FromContext(
       v8::Handle<v8::Context> context = v8::Handle<v8::Context>());
 
@@ -0,0 +1,105 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#include "modules/io/StatCache.h"
+
+#include <errno.h>
+#include <time.h>
+
+namespace modules {
+namespace io {
+
+namespace {
+
+double Now() {
+  struct timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+std::string Parent(const std::string& path) {
+  std::string::size_type slash = path.find_last_of('/');
+
+  if (slash == std::string::npos)
+    return ".";
+  if (slash == 0)
+    return "/";
+  return path.substr(0, slash);
+}
+
+}
+
+StatCache::StatCache(double ttl, size_t max_entries)
+    : ttl_(ttl)
+    , max_entries_(max_entries) {
+}
+
+int StatCache::Stat(const std::string& path, struct stat& status) {
+  int error;
+
+  if (Lookup(path, status, error))
+    return error;
+
+  error = ::stat(path.c_str(), &status) == -1 ? errno : 0;
+  Store(path, status, error);
+  return error;
+}
+
+bool StatCache::Lookup(const std::string& path, struct stat& status,
+                       int& error) {
+  std::unordered_map<std::string, Entry>::iterator iter(entries_.find(path));
+
+  if (iter == entries_.end())
+    return false;
+
+  if (iter->second.expires <= Now()) {
+    entries_.erase(iter);
+    return false;
+  }
+
+  status = iter->second.status;
+  error = iter->second.error;
+  return true;
+}
+
+void StatCache::Store(const std::string& path, const struct stat& status,
+                      int error) {
+  /* Simpler than tracking usage, and a full cache is most likely the result
+     of a walk over more files than are ever looked at again. */
+  if (entries_.size() >= max_entries_)
+    entries_.clear();
+
+  Entry& entry(entries_[path]);
+
+  entry.status = status;
+  entry.error = error;
+  entry.expires = Now() + ttl_;
+}
+
+void StatCache::Invalidate(const std::string& path) {
+  entries_.erase(path);
+  entries_.erase(Parent(path));
+}
+
+void StatCache::Clear() {
+  entries_.clear();
+}
+
+}
+}
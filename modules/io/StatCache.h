@@ -0,0 +1,70 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#ifndef MODULES_IO_STATCACHE_H
+#define MODULES_IO_STATCACHE_H
+
+#include <sys/stat.h>
+
+#include <string>
+#include <unordered_map>
+
+namespace modules {
+namespace io {
+
+/* Path-keyed cache of stat() results, including failures, for read-mostly
+   workloads such as build scripts that check the same files over and over.
+   Entries expire after a fixed time; IO.File's own operations that change
+   files, and IO.batch() writes, also invalidate the affected entries.
+   Changes made through open IO.File objects (other than by opening them
+   for writing) or by other processes are only noticed when the entries
+   expire, or when an IO.Watcher reports them. */
+class StatCache {
+ public:
+  StatCache(double ttl, size_t max_entries);
+
+  int Stat(const std::string& path, struct stat& status);
+  /**< Like ::stat(), but returns zero or an errno value, served from the
+       cache when possible. */
+
+  bool Lookup(const std::string& path, struct stat& status, int& error);
+  void Store(const std::string& path, const struct stat& status, int error);
+
+  void Invalidate(const std::string& path);
+  /**< Forget 'path' and its parent directory, whose size and modification
+       time change when entries are added or removed. */
+  void Clear();
+
+ private:
+  struct Entry {
+    struct stat status;
+    int error;
+    double expires;
+  };
+
+  double ttl_;
+  size_t max_entries_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+}
+}
+
+#endif // MODULES_IO_STATCACHE_H
@@ -0,0 +1,430 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "modules/io/Watcher.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "modules/builtin/EventLoop.h"
+#include "modules/io/Directory.h"
+#include "modules/io/File.h"
+#include "modules/io/IOError.h"
+
+namespace modules {
+namespace io {
+
+namespace {
+
+const std::uint32_t kWatchMask =
+    IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+    IN_EXCL_UNLINK;
+
+enum {
+  kCreated = 1 << 0,
+  kModified = 1 << 1,
+  kDeleted = 1 << 2,
+  kAttributes = 1 << 3,
+  kDirectory = 1 << 4
+};
+
+double Now() {
+  struct timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+std::string Normalize(std::string path) {
+  while (path.length() > 1 && path[path.length() - 1] == '/')
+    path.erase(path.length() - 1);
+  return path;
+}
+
+}
+
+class Watcher::Instance : public api::Class::Instance<Watcher> {
+ public:
+  Instance(int fd, double coalesce, double max_delay);
+  ~Instance();
+
+  void Add(const std::string& path, bool recursive, bool report);
+  void Remove(const std::string& path);
+  void Forget(const std::string& path, bool subtree);
+
+  bool Wait(double timeout);
+  void Drain();
+  void Record(const std::string& path, unsigned flags);
+
+  struct Watch {
+    std::string path;
+    bool recursive;
+  };
+
+  struct Change {
+    std::string path;
+    unsigned flags;
+  };
+
+  int fd;
+  double coalesce;
+  double max_delay;
+  bool overflow;
+
+  std::unordered_map<int, Watch> watches;
+  std::unordered_map<std::string, int> descriptors;
+
+  /* Changes collected by the current read(), one per path, in the order the
+     paths were first reported. */
+  std::vector<Change> changes;
+  std::unordered_map<std::string, size_t> indexes;
+};
+
+Watcher::Instance::Instance(int fd, double coalesce, double max_delay)
+    : fd(fd)
+    , coalesce(coalesce)
+    , max_delay(max_delay)
+    , overflow(false) {
+}
+
+Watcher::Instance::~Instance() {
+  if (fd != -1)
+    ::close(fd);
+}
+
+void Watcher::Instance::Add(const std::string& path, bool recursive,
+                            bool report) {
+  int wd = ::inotify_add_watch(fd, path.c_str(), kWatchMask);
+  if (wd == -1) {
+    if (report)
+      return;
+    throw IOError("inotify_add_watch() failed", errno) << " (" << path << ")";
+  }
+
+  Watch& watch = watches[wd];
+  if (!watch.path.empty() && watch.path != path)
+    descriptors.erase(watch.path);
+  watch.path = path;
+  watch.recursive = watch.recursive || recursive;
+  descriptors[path] = wd;
+
+  if (!recursive)
+    return;
+
+  std::vector<Directory::Entry> entries;
+  if (Directory::Walk(path, Directory::WalkOptions(), entries) != 0)
+    return;
+
+  for (auto iter(entries.begin()); iter != entries.end(); ++iter) {
+    const Directory::Entry& entry(*iter);
+
+    /* When watching a directory that was just created, anything in it may
+       have been created before the watch was added, and would otherwise
+       never be reported. */
+    if (report)
+      Record(entry.name, kCreated | (entry.type == 'd' ? kDirectory : 0));
+
+    if (entry.type != 'd')
+      continue;
+
+    /* Subdirectories may disappear under our feet; that's not an error. */
+    wd = ::inotify_add_watch(fd, entry.name.c_str(), kWatchMask | IN_ONLYDIR);
+    if (wd == -1)
+      continue;
+
+    Watch& subwatch = watches[wd];
+    if (!subwatch.path.empty() && subwatch.path != entry.name)
+      descriptors.erase(subwatch.path);
+    subwatch.path = entry.name;
+    subwatch.recursive = true;
+    descriptors[entry.name] = wd;
+  }
+}
+
+void Watcher::Instance::Remove(const std::string& path) {
+  std::unordered_map<std::string, int>::iterator iter(descriptors.find(path));
+  if (iter == descriptors.end())
+    throw base::TypeError("path not watched: " + path);
+
+  Forget(path, watches[iter->second].recursive);
+}
+
+void Watcher::Instance::Forget(const std::string& path, bool subtree) {
+  std::string prefix(path == "/" ? path : path + "/");
+
+  for (auto iter(descriptors.begin()); iter != descriptors.end();) {
+    if (iter->first == path ||
+        (subtree && iter->first.compare(0, prefix.length(), prefix) == 0)) {
+      /* The kernel queues an IN_IGNORED event for the descriptor, which
+         Drain() skips since it's no longer known. */
+      ::inotify_rm_watch(fd, iter->second);
+      watches.erase(iter->second);
+      iter = descriptors.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+bool Watcher::Instance::Wait(double timeout) {
+  struct pollfd pfd;
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+
+  int result;
+  do
+    result = ::poll(&pfd, 1, timeout < 0 ? -1 : static_cast<int>(timeout));
+  while (result == -1 && errno == EINTR);
+
+  if (result == -1)
+    throw IOError("poll() failed", errno);
+
+  return result != 0;
+}
+
+void Watcher::Instance::Drain() {
+  alignas(struct inotify_event) char buffer[65536];
+
+  while (true) {
+    ssize_t nread = ::read(fd, buffer, sizeof buffer);
+
+    if (nread == -1) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN)
+        return;
+      throw IOError("read() failed", errno);
+    }
+
+    for (char* ptr = buffer; ptr < buffer + nread;) {
+      const struct inotify_event* event =
+          reinterpret_cast<const struct inotify_event*>(ptr);
+
+      ptr += sizeof *event + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        overflow = true;
+        continue;
+      }
+
+      std::unordered_map<int, Watch>::iterator iter(watches.find(event->wd));
+      if (iter == watches.end())
+        continue;
+
+      if (event->mask & IN_IGNORED) {
+        /* The watched file was deleted or its file system unmounted. */
+        descriptors.erase(iter->second.path);
+        watches.erase(iter);
+        continue;
+      }
+
+      /* Events without a name concern the watched file itself. */
+      std::string path(iter->second.path);
+      if (event->len != 0)
+        path += (path == "/" ? "" : "/") + std::string(event->name);
+      bool recursive = iter->second.recursive;
+
+      unsigned flags = (event->mask & IN_ISDIR) ? kDirectory : 0;
+
+      if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        flags |= kCreated;
+      if (event->mask & (IN_MODIFY | IN_CLOSE_WRITE))
+        flags |= kModified;
+      if (event->mask & (IN_DELETE | IN_MOVED_FROM |
+                         IN_DELETE_SELF | IN_MOVE_SELF))
+        flags |= kDeleted;
+      if (event->mask & IN_ATTRIB)
+        flags |= kAttributes;
+
+      Record(path, flags);
+
+      if (!(event->mask & IN_ISDIR) || !recursive)
+        continue;
+
+      /* Directories moved within the tree are watched again under their new
+         path, since the old watches' paths would be stale. */
+      if (event->mask & IN_MOVED_FROM)
+        Forget(path, true);
+      else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        Add(path, true, true);
+    }
+  }
+}
+
+void Watcher::Instance::Record(const std::string& path, unsigned flags) {
+  std::unordered_map<std::string, size_t>::iterator iter(indexes.find(path));
+
+  if (iter == indexes.end()) {
+    Change change;
+
+    change.path = path;
+    change.flags = flags;
+
+    indexes[path] = changes.size();
+    changes.push_back(change);
+  } else {
+    changes[iter->second].flags |= flags;
+  }
+}
+
+Watcher::Watcher()
+    : api::Class("Watcher", constructor) {
+  AddMethod<Watcher>("add", add);
+  AddMethod<Watcher>("remove", remove);
+  AddMethod<Watcher>("read", read);
+  AddMethod<Watcher>("fileno", fileno);
+  AddMethod<Watcher>("close", close);
+
+  AddProperty<Watcher>("watching", get_watching);
+  AddProperty<Watcher>("overflow", get_overflow);
+  AddProperty<Watcher>("closed", get_closed);
+}
+
+Watcher::Instance* Watcher::constructor(Watcher*,
+                                        utilities::Options options) {
+  double coalesce = options.GetNumber("coalesce", 0);
+  double max_delay = options.GetNumber("maxDelay", coalesce * 10);
+
+  if (coalesce < 0 || max_delay < 0)
+    throw base::RangeError("invalid coalesce delay; must be non-negative");
+
+  int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd == -1)
+    throw IOError("inotify_init1() failed", errno);
+
+  return new Instance(fd, coalesce, max_delay);
+}
+
+void Watcher::add(Instance* instance, std::string path,
+                  utilities::Options options) {
+  if (instance->fd == -1)
+    throw base::TypeError("watcher closed");
+
+  instance->Add(Normalize(path), options.GetBoolean("recursive"), false);
+}
+
+void Watcher::remove(Instance* instance, std::string path) {
+  if (instance->fd == -1)
+    throw base::TypeError("watcher closed");
+
+  instance->Remove(Normalize(path));
+}
+
+std::vector<base::Variant> Watcher::read(Instance* instance,
+                                         Optional<double> timeout) {
+  if (instance->fd == -1)
+    throw base::TypeError("watcher closed");
+
+  instance->overflow = false;
+  instance->changes.clear();
+  instance->indexes.clear();
+
+  if (timeout.specified() && !instance->Wait(timeout.value()))
+    return std::vector<base::Variant>();
+
+  instance->Drain();
+
+  /* Saving a file typically produces a burst of events (create, several
+     modifications, attribute changes); keep reading until the watched files
+     have been quiet for the coalescing delay, so that the burst is reported
+     as one change per path. */
+  if (instance->coalesce > 0 && !instance->changes.empty()) {
+    double deadline = Now() + instance->max_delay;
+
+    while (true) {
+      double remaining = deadline - Now();
+      if (remaining <= 0 ||
+          !instance->Wait(std::min(instance->coalesce, remaining)))
+        break;
+      instance->Drain();
+    }
+  }
+
+  File* file = File::FromContext();
+
+  if (instance->overflow)
+    file->ClearStatCache();
+
+  std::vector<base::Variant> result;
+
+  for (auto iter(instance->changes.begin()); iter != instance->changes.end();
+       ++iter) {
+    base::Object object(base::Object::Create());
+    unsigned flags = iter->flags;
+
+    file->InvalidateStat(iter->path);
+
+    object.Put("path", base::Variant::String(iter->path));
+    object.Put("created", base::Variant::Boolean((flags & kCreated) != 0));
+    object.Put("modified", base::Variant::Boolean((flags & kModified) != 0));
+    object.Put("deleted", base::Variant::Boolean((flags & kDeleted) != 0));
+    object.Put("attributes",
+               base::Variant::Boolean((flags & kAttributes) != 0));
+    object.Put("directory", base::Variant::Boolean((flags & kDirectory) != 0));
+
+    result.push_back(object);
+  }
+
+  instance->changes.clear();
+  instance->indexes.clear();
+
+  return result;
+}
+
+int Watcher::fileno(Instance* instance) {
+  if (instance->fd == -1)
+    throw base::TypeError("watcher closed");
+
+  return instance->fd;
+}
+
+void Watcher::close(Instance* instance) {
+  if (instance->fd == -1)
+    throw base::TypeError("watcher closed");
+
+  /* Stops watch() callbacks before the descriptor number can be reused. */
+  builtin::EventLoop::FromContext()->CancelWatches(instance->fd);
+
+  ::close(instance->fd);
+  instance->fd = -1;
+  instance->watches.clear();
+  instance->descriptors.clear();
+}
+
+unsigned Watcher::get_watching(Instance* instance) {
+  return instance->watches.size();
+}
+
+bool Watcher::get_overflow(Instance* instance) {
+  return instance->overflow;
+}
+
+bool Watcher::get_closed(Instance* instance) {
+  return instance->fd == -1;
+}
+
+}
+}
@@ -0,0 +1,54 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef MODULES_IO_WATCHER_H
+#define MODULES_IO_WATCHER_H
+
+#include "api/Class.h"
+#include "utilities/Options.h"
+
+namespace modules {
+namespace io {
+
+class Watcher : public api::Class {
+ public:
+  class Instance;
+
+  Watcher();
+
+ private:
+  static Instance* constructor(Watcher*, utilities::Options options);
+
+  static void add(Instance* instance, std::string path,
+                  utilities::Options options);
+  static void remove(Instance* instance, std::string path);
+  static std::vector<base::Variant> read(Instance* instance,
+                                         Optional<double> timeout);
+  static int fileno(Instance* instance);
+  static void close(Instance* instance);
+
+  static unsigned get_watching(Instance* instance);
+  static bool get_overflow(Instance* instance);
+  static bool get_closed(Instance* instance);
+};
+
+}
+}
+
+#endif // MODULES_IO_WATCHER_H
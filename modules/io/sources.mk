@@ -20,7 +20,12 @@ common_sources += modules/io/IOError.cc \
                   modules/io/SocketAddress.cc \
                   modules/io/Poll.cc \
                   modules/io/Stat.cc \
+                  modules/io/StatCache.cc \
                   modules/io/IOThread.cc \
                   modules/io/Pipe.cc \
                   modules/io/Buffered.cc \
-                  modules/io/Path.cc
+                  modules/io/BufferedWriter.cc \
+                  modules/io/Batch.cc \
+                  modules/io/Directory.cc \
+                  modules/io/Path.cc \
+                  modules/io/Watcher.cc
@@ -26,15 +26,19 @@
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
 #include <signal.h>
 #include <unistd.h>
 
 #include <map>
+#include <memory>
 
 #include "modules/Modules.h"
 #include "modules/OS.h"
 #include "modules/os/OSError.h"
 #include "modules/io/IOThread.h"
+#include "modules/builtin/EventLoop.h"
 
 extern char** environ;
 
@@ -76,6 +80,7 @@ Process::Process(const Features& features)
     , shell_disabled_(features.Disabled("OS.Process::shell")) {
   AddMethod<Process>("start", start);
   AddMethod<Process>("wait", wait);
+  AddMethod<Process>("waitAsync", waitAsync);
   AddMethod<Process>("kill", kill);
   AddMethod<Process>("run", run);
   AddMethod<Process>("call", call);
@@ -309,6 +314,9 @@ void Process::start(Instance* instance) {
     }
   }
 
+  /* Don't let the child inherit (and later write) buffered output. */
+  ::fflush(stdout);
+
   pid_t pid = ::fork();
 
   if (pid == -1)
@@ -449,6 +457,55 @@ bool Process::wait(Instance* instance, Optional<bool> nohang) {
   return true;
 }
 
+namespace {
+
+/* A pidfd (Linux 5.3 and later) becomes readable when the process exits,
+   which lets the event loop wait for it.  Closed when the wait is over. */
+class PidFD {
+ public:
+  PidFD(pid_t pid)
+#if defined(SYS_pidfd_open)
+      : fd(::syscall(SYS_pidfd_open, pid, 0)) {
+#else
+      : fd(-1) {
+#endif
+  }
+
+  ~PidFD() {
+    if (fd != -1)
+      ::close(fd);
+  }
+
+  int fd;
+};
+
+}
+
+base::Object Process::waitAsync(Instance* instance) {
+  if (instance->pid == -1)
+    throw OSError("process not started");
+  else if (instance->is_self)
+    throw OSError("waiting on self would deadlock");
+
+  builtin::EventLoop* event_loop = builtin::EventLoop::FromContext();
+  std::shared_ptr<PidFD> pidfd(new PidFD(instance->pid));
+
+  builtin::EventLoop::Attempt attempt(
+      [instance, pidfd](builtin::EventLoop::Promise& promise) {
+        if (!wait(instance, true))
+          return false;
+        promise.Resolve(instance->GetObject());
+        return true;
+      });
+
+  if (pidfd->fd != -1)
+    return event_loop->WhenReady(pidfd->fd, EPOLLIN, attempt,
+                                 instance->GetObject());
+
+  /* No pidfd support; check periodically instead. */
+  return event_loop->WhenTrue(10, attempt, instance->GetObject());
+}
+
 void Process::kill(Instance* instance, int signal) {
   if (instance->pid == -1)
     throw OSError("process not started");
@@ -519,6 +576,9 @@ void Process::kill(Process*, int pid, int signal) {
 }
 
 int Process::fork(Process*) {
+  /* Don't let the child inherit (and later write) buffered output. */
+  ::fflush(stdout);
+
   pid_t pid = ::fork();
 
   if (pid == -1)
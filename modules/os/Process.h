@@ -66,6 +66,7 @@ class Process : public api::Class {
 
   static void start(Instance* instance);
   static bool wait(Instance* instance, Optional<bool> nohang);
+  static base::Object waitAsync(Instance* instance);
   static void kill(Instance* instance, int signal);
   static void run(Instance* instance);
   static std::string call(Instance* instance, Optional<std::string> stdin);
@@ -12,11 +12,12 @@
 # License for the specific language governing permissions and limitations under
 # the License.
 
-modules = builtin io memcache os postgresql url zlib testing
+modules = builtin io hash memcache os postgresql url zlib testing
 
 common_sources += modules/Modules.cc \
                   modules/BuiltIn.cc \
                   modules/IO.cc \
+                  modules/Hash.cc \
                   modules/MemCache.cc \
                   modules/OS.cc \
                   modules/PostgreSQL.cc \
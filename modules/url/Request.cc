@@ -23,12 +23,17 @@
 #include <curl/curl.h>
 #include <stdexcept>
 #include <string.h>
+#include <strings.h>
 
 #include "modules/URL.h"
 #include "modules/url/Header.h"
 #include "modules/url/URLError.h"
 #include "utilities/Anchor.h"
 
+#if ZLIB_SUPPORT
+#include "modules/zlib/Stream.h"
+#endif
+
 namespace modules {
 namespace url {
 
@@ -39,6 +44,7 @@ class Request::Instance : public api::Class::Instance<Request> {
       , url(url)
       , auth_method(CURLAUTH_NONE)
       , verify_peer(true)
+      , decode_response(true)
       , performed(false)
       , status_code(0) {
   }
@@ -50,6 +56,9 @@ class Request::Instance : public api::Class::Instance<Request> {
   std::string password;
   long auth_method;
   bool verify_peer;
+  bool decode_response;
+  std::string accept_encoding;
+  std::string request_encoding;
   std::string request_body;
   size_t request_body_sent;
   bool performed;
@@ -141,6 +150,8 @@ Request::Request()
   AddMethod<Request>("setRequestHeader", &setRequestHeader);
   AddMethod<Request>("setRequestBody", &setRequestBody);
   AddMethod<Request>("setVerifyPeer", &setVerifyPeer);
+  AddMethod<Request>("setAcceptEncoding", &setAcceptEncoding);
+  AddMethod<Request>("setRequestEncoding", &setRequestEncoding);
   AddMethod<Request>("perform", &perform);
 
   AddProperty<Request>("statusLine", &get_statusLine);
@@ -241,10 +252,72 @@ void Request::setVerifyPeer(Instance* instance, bool value) {
   instance->verify_peer = value;
 }
 
+void Request::setAcceptEncoding(Instance* instance, base::Variant value) {
+  if (instance->performed)
+    throw URLError("request already performed");
+
+  /* An empty string tells libcurl to offer every encoding it supports, and to
+     transparently decode the response body. */
+  if (value.IsBoolean()) {
+    instance->decode_response = value.AsBoolean();
+    instance->accept_encoding = "";
+  } else {
+    instance->decode_response = true;
+    instance->accept_encoding = value.AsString();
+  }
+}
+
+void Request::setRequestEncoding(Instance* instance, std::string encoding) {
+  if (instance->performed)
+    throw URLError("request already performed");
+
+  if (encoding == "identity")
+    encoding = "";
+  else if (!encoding.empty() && encoding != "gzip" && encoding != "deflate")
+    throw URLError("invalid request encoding: ") << encoding;
+
+#if !ZLIB_SUPPORT
+  if (!encoding.empty())
+    throw URLError("request encoding requires ZLib support");
+#endif
+
+  instance->request_encoding = encoding;
+}
+
+namespace {
+
+void EncodeRequestBody(Request::Instance* instance) {
+#if ZLIB_SUPPORT
+  zlib::Stream::Format format;
+
+  if (instance->request_encoding == "gzip")
+    format = zlib::Stream::Format::kGZip;
+  else
+    format = zlib::Stream::Format::kZLib;
+
+  instance->request_body = zlib::Stream::Compress(
+      instance->request_body, -1, format);
+  instance->request_body_sent = 0;
+#endif
+}
+
+}
+
 void Request::perform(Instance* instance) {
   if (instance->performed)
     throw URLError("request already performed");
 
+  /* The encoding is announced by its own Content-Encoding header, which a
+     second one set by the caller would contradict. */
+  if (!instance->request_encoding.empty()) {
+    for (auto iter(instance->request_headers.begin());
+         iter != instance->request_headers.end();
+         ++iter)
+      if (strcasecmp(iter->first.c_str(), "Content-Encoding") == 0)
+        throw URLError("request encoding conflicts with Content-Encoding "
+                       "header");
+  }
+
   if (!curl_handle)
     Initialize();
   else
@@ -260,10 +333,22 @@ void Request::perform(Instance* instance) {
       headers = curl_slist_append(headers, header.c_str());
       ++iter;
     }
+  }
 
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+  if (instance->request_body.length() && !instance->request_encoding.empty()) {
+    EncodeRequestBody(instance);
+
+    std::string header = "Content-Encoding: " + instance->request_encoding;
+    headers = curl_slist_append(headers, header.c_str());
   }
 
+  if (headers)
+    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+
+  if (instance->decode_response)
+    curl_easy_setopt(curl_handle, CURLOPT_ACCEPT_ENCODING,
+                     instance->accept_encoding.c_str());
+
   if (instance->request_body.length()) {
     if (instance->method == "POST") {
       curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
@@ -383,6 +468,12 @@ void Request::HandleOptions(Instance* instance,
 
   if (options.Has("verify_peer"))
     setVerifyPeer(instance, options.GetBoolean("verify_peer"));
+
+  if (options.Has("accept_encoding"))
+    setAcceptEncoding(instance, options.Get("accept_encoding"));
+
+  if (options.Has("request_encoding"))
+    setRequestEncoding(instance, options.GetString("request_encoding"));
 }
 
 }
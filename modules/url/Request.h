@@ -60,6 +60,8 @@ class Request : public api::Class {
   static void setRequestBody(Instance* instance,
                              builtin::Bytes::Value value);
   static void setVerifyPeer(Instance* instance, bool value);
+  static void setAcceptEncoding(Instance* instance, base::Variant value);
+  static void setRequestEncoding(Instance* instance, std::string encoding);
   static void perform(Instance* instance);
 
   static std::string get_statusLine(Instance* instance);
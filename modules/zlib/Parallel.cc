@@ -0,0 +1,258 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#include "Base.h"
+#include "modules/zlib/Parallel.h"
+
+#include <zlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "modules/zlib/Error.h"
+#include "utilities/ThreadPool.h"
+
+namespace modules {
+namespace zlib {
+
+namespace {
+
+const size_t kWindowSize = 32768;
+
+struct Block {
+  Block()
+      : check(0)
+      , failed(false) {
+  }
+
+  const Bytef* data;
+  size_t length;
+
+  std::string output;
+  uLong check;
+  bool failed;
+};
+
+class Job {
+ public:
+  Job(const Stream::Parameters& parameters, bool gzip,
+      std::vector<Block>& blocks)
+      : parameters_(parameters)
+      , gzip_(gzip)
+      , blocks_(blocks) {
+  }
+
+  void Compress(Block& block);
+
+ private:
+  const Stream::Parameters& parameters_;
+  bool gzip_;
+  std::vector<Block>& blocks_;
+};
+
+void Job::Compress(Block& block) {
+  z_stream impl;
+
+  /* Worker threads must not touch the isolate, so the default allocator is
+     used here rather than Stream's, which reports to V8. */
+  impl.zalloc = Z_NULL;
+  impl.zfree = Z_NULL;
+  impl.opaque = Z_NULL;
+
+  int window_bits = parameters_.window_bits;
+  if (window_bits > MAX_WBITS)
+    window_bits -= 16;
+  if (window_bits > 0)
+    window_bits = -window_bits;
+
+  if (deflateInit2(&impl, parameters_.level, Z_DEFLATED, window_bits,
+                   parameters_.mem_level, parameters_.strategy) != Z_OK) {
+    block.failed = true;
+    return;
+  }
+
+  if (&block != &blocks_.front()) {
+    size_t window = std::min(kWindowSize, (&block - 1)->length);
+    deflateSetDictionary(&impl, block.data - window, window);
+  }
+
+  bool last = &block == &blocks_.back();
+  int ret;
+
+  impl.next_in = const_cast<Bytef*>(block.data);
+  impl.avail_in = block.length;
+
+  /* Every block but the last ends with a sync flush, which byte-aligns the
+     output without marking the deflate stream as finished. */
+  block.output.resize(deflateBound(&impl, block.length) + 16);
+
+  size_t produced = 0;
+
+  do {
+    if (produced == block.output.size())
+      block.output.resize(block.output.size() * 2);
+
+    impl.next_out = reinterpret_cast<Bytef*>(&block.output[produced]);
+    impl.avail_out = block.output.size() - produced;
+
+    ret = deflate(&impl, last ? Z_FINISH : Z_SYNC_FLUSH);
+
+    produced = block.output.size() - impl.avail_out;
+  } while (ret == Z_OK && impl.avail_out == 0);
+
+  deflateEnd(&impl);
+
+  /* Z_BUF_ERROR just means a repeated flush had nothing more to emit. */
+  if (last ? ret != Z_STREAM_END : ret != Z_OK && ret != Z_BUF_ERROR) {
+    block.failed = true;
+    return;
+  }
+
+  block.output.resize(produced);
+
+  if (gzip_)
+    block.check = crc32(0, block.data, block.length);
+  else
+    block.check = adler32(1, block.data, block.length);
+}
+
+void PutBigEndian32(unsigned char* target, uLong value) {
+  target[0] = value >> 24;
+  target[1] = value >> 16;
+  target[2] = value >> 8;
+  target[3] = value;
+}
+
+void PutLittleEndian32(unsigned char* target, uLong value) {
+  target[0] = value;
+  target[1] = value >> 8;
+  target[2] = value >> 16;
+  target[3] = value >> 24;
+}
+
+}
+
+builtin::Bytes::Value Parallel::Deflate(builtin::Bytes::Value data,
+                                        const Stream::Parameters& parameters,
+                                        unsigned threads, size_t block_size) {
+  const Bytef* input = static_cast<const Bytef*>(data.data());
+  size_t length = data.length();
+
+  bool gzip = parameters.window_bits > MAX_WBITS;
+  bool raw = parameters.window_bits < 0;
+
+  std::vector<Block> blocks((length + block_size - 1) / block_size);
+
+  if (blocks.empty())
+    blocks.resize(1);
+
+  for (size_t index = 0; index < blocks.size(); ++index) {
+    blocks[index].data = input + index * block_size;
+    blocks[index].length = std::min(block_size, length - index * block_size);
+  }
+
+  Job job(parameters, gzip, blocks);
+
+  utilities::ThreadPool::Shared().ForEach(
+      blocks.size(), threads,
+      [&job, &blocks](size_t index) { job.Compress(blocks[index]); });
+
+  unsigned char header[10];
+  size_t header_length = 0;
+
+  if (gzip) {
+    /* Magic, CM=deflate, no flags, no mtime, XFL=0, OS=Unix. */
+    const unsigned char gzip_header[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+    memcpy(header, gzip_header, sizeof gzip_header);
+    header_length = sizeof gzip_header;
+  } else if (!raw) {
+    int level = parameters.level;
+    int flevel;
+
+    /* As computed by deflate(), which sees the default level as 6. */
+    if (level == Z_DEFAULT_COMPRESSION)
+      level = 6;
+
+    if (parameters.strategy >= Z_HUFFMAN_ONLY || level < 2)
+      flevel = 0;
+    else if (level < 6)
+      flevel = 1;
+    else if (level == 6)
+      flevel = 2;
+    else
+      flevel = 3;
+
+    unsigned cmf = ((parameters.window_bits - 8) << 4) | Z_DEFLATED;
+    unsigned flg = flevel << 6;
+    flg += 31 - ((cmf << 8) + flg) % 31;
+
+    header[0] = cmf;
+    header[1] = flg;
+    header_length = 2;
+  }
+
+  uLong check = gzip ? crc32(0, Z_NULL, 0) : adler32(0, Z_NULL, 0);
+  size_t total = header_length;
+
+  for (auto iter(blocks.begin()); iter != blocks.end(); ++iter) {
+    if (iter->failed)
+      throw Error("Stream error");
+
+    if (gzip)
+      check = crc32_combine(check, iter->check, iter->length);
+    else
+      check = adler32_combine(check, iter->check, iter->length);
+
+    total += iter->output.length();
+  }
+
+  unsigned char trailer[8];
+  size_t trailer_length = 0;
+
+  if (gzip) {
+    PutLittleEndian32(trailer, check);
+    PutLittleEndian32(trailer + 4, length & 0xffffffffu);
+    trailer_length = 8;
+  } else if (!raw) {
+    PutBigEndian32(trailer, check);
+    trailer_length = 4;
+  }
+
+  total += trailer_length;
+
+  builtin::Bytes::Value result(
+      builtin::Bytes::FromContext()->NewUninitialized(total));
+  char* target = static_cast<char*>(result.data());
+
+  memcpy(target, header, header_length);
+  target += header_length;
+
+  for (auto iter(blocks.begin()); iter != blocks.end(); ++iter) {
+    memcpy(target, iter->output.data(), iter->output.length());
+    target += iter->output.length();
+  }
+
+  memcpy(target, trailer, trailer_length);
+
+  return result;
+}
+
+}
+}
@@ -0,0 +1,49 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef MODULES_ZLIB_PARALLEL_H
+#define MODULES_ZLIB_PARALLEL_H
+
+#if ZLIB_SUPPORT
+
+#include "modules/builtin/Bytes.h"
+#include "modules/zlib/Stream.h"
+
+namespace modules {
+namespace zlib {
+
+class Parallel {
+ public:
+  static builtin::Bytes::Value Deflate(builtin::Bytes::Value data,
+                                       const Stream::Parameters& parameters,
+                                       unsigned threads, size_t block_size);
+  /**< Deflate 'data' by splitting it into blocks of 'block_size' bytes and
+       compressing them on up to 'threads' threads from the shared thread
+       pool.  The blocks are joined into a single stream in the format
+       selected by 'parameters', with a combined checksum, that any inflater
+       can decode.  Each block is primed with the last 32 KiB of the
+       preceding block, so the ratio stays close to that of a serial
+       deflate. */
+};
+
+}
+}
+
+#endif // ZLIB_SUPPORT
+#endif // MODULES_ZLIB_PARALLEL_H
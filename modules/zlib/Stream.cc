@@ -21,7 +21,11 @@
 #include "modules/zlib/Stream.h"
 
 #include <zlib.h>
+#include <string.h>
+
+#include <deque>
 #include <limits>
+#include <vector>
 
 #include "modules/zlib/Error.h"
 #include "utilities/Anchor.h"
@@ -31,19 +35,37 @@ namespace zlib {
 
 class Stream::Instance : public api::Class::Instance<Stream> {
  public:
-  Instance(int level);
+  Instance(const Parameters& parameters, bool track_memory = true);
   ~Instance();
 
-  bool is_inflate() { return level == std::numeric_limits<int>::min(); }
-  bool is_deflate() { return level != std::numeric_limits<int>::min(); }
+  bool is_inflate() { return inflate; }
+  bool is_deflate() { return !inflate; }
 
   void close();
 
+  /* Output is produced directly into fixed size chunks.  Chunks that have
+     been read are kept around (up to a limit) and reused, so that a stream
+     that is read as it is written runs in constant memory. */
+  struct Chunk {
+    char* data;
+    size_t begin;
+    size_t end;
+  };
+
+  static const size_t kChunkSize = 65536;
+  static const size_t kMaximumSpareChunks = 4;
+
+  Chunk& WritableChunk();
+  size_t Consume(char* target, size_t nbytes);
+
   z_stream impl;
-  int level;
+  bool inflate;
   bool closed;
+  std::string dictionary;
 
-  std::string buffered;
+  std::deque<Chunk> output;
+  std::vector<char*> spare;
+  size_t available;
 };
 
 namespace {
@@ -67,21 +89,59 @@ void zfree(void*, void* address) {
 
 }
 
-Stream::Instance::Instance(int level)
-    : level(level)
-    , closed(false) {
-  impl.zalloc = zalloc;
-  impl.zfree = zfree;
+Stream::Instance::Instance(const Parameters& parameters, bool track_memory)
+    : inflate(parameters.inflate)
+    , closed(false)
+    , dictionary(parameters.dictionary)
+    , available(0) {
+  /* Reporting memory use to V8 requires the isolate, so streams used off the
+     main thread use zlib's default allocator. */
+  impl.zalloc = track_memory ? zalloc : Z_NULL;
+  impl.zfree = track_memory ? zfree : Z_NULL;
   impl.opaque = Z_NULL;
+  impl.next_in = Z_NULL;
+  impl.avail_in = 0;
+
+  int ret;
 
   if (is_inflate())
-    inflateInit(&impl);
+    ret = inflateInit2(&impl, parameters.window_bits);
   else
-    deflateInit(&impl, level);
+    ret = deflateInit2(&impl, parameters.level, Z_DEFLATED,
+                       parameters.window_bits, parameters.mem_level,
+                       parameters.strategy);
+
+  if (ret != Z_OK) {
+    closed = true;
+    throw Error(ret == Z_MEM_ERROR ? "Memory error" : "Invalid parameters");
+  }
+
+  /* A deflate stream is primed with the dictionary up front.  So is a raw
+     inflate stream, since raw streams carry no dictionary identifier and
+     inflate() would never ask for it. */
+  if (!dictionary.empty() &&
+      (is_deflate() || parameters.window_bits < 0)) {
+    const Bytef* data = reinterpret_cast<const Bytef*>(dictionary.data());
+
+    if (is_deflate())
+      ret = deflateSetDictionary(&impl, data, dictionary.length());
+    else
+      ret = inflateSetDictionary(&impl, data, dictionary.length());
+
+    if (ret != Z_OK) {
+      close();
+      throw Error("Invalid dictionary");
+    }
+  }
 }
 
 Stream::Instance::~Instance() {
   close();
+
+  for (auto iter(output.begin()); iter != output.end(); ++iter)
+    delete[] iter->data;
+  for (auto iter(spare.begin()); iter != spare.end(); ++iter)
+    delete[] *iter;
 }
 
 void Stream::Instance::close() {
@@ -95,32 +155,144 @@ void Stream::Instance::close() {
   }
 }
 
+Stream::Instance::Chunk& Stream::Instance::WritableChunk() {
+  if (output.empty() || output.back().end == kChunkSize) {
+    Chunk chunk;
+
+    if (spare.empty()) {
+      chunk.data = new char[kChunkSize];
+    } else {
+      chunk.data = spare.back();
+      spare.pop_back();
+    }
+
+    chunk.begin = chunk.end = 0;
+    output.push_back(chunk);
+  }
+
+  return output.back();
+}
+
+size_t Stream::Instance::Consume(char* target, size_t nbytes) {
+  size_t consumed = 0;
+
+  while (consumed < nbytes && !output.empty()) {
+    Chunk& chunk = output.front();
+    size_t length = std::min(nbytes - consumed, chunk.end - chunk.begin);
+
+    memcpy(target + consumed, chunk.data + chunk.begin, length);
+
+    consumed += length;
+    chunk.begin += length;
+
+    if (chunk.begin == chunk.end) {
+      if (spare.size() < kMaximumSpareChunks)
+        spare.push_back(chunk.data);
+      else
+        delete[] chunk.data;
+      output.pop_front();
+    }
+  }
+
+  available -= consumed;
+  return consumed;
+}
+
+Stream::Parameters::Parameters(bool inflate)
+    : inflate(inflate)
+    , level(Z_DEFAULT_COMPRESSION)
+    , window_bits(MAX_WBITS)
+    , mem_level(8)
+    , strategy(Z_DEFAULT_STRATEGY) {
+}
+
 Stream::Stream()
     : api::Class("Stream", &constructor) {
   AddMethod<Stream>("write", write);
   AddMethod<Stream>("flush", flush);
   AddMethod<Stream>("close", close);
   AddMethod<Stream>("read", read);
+  AddMethod<Stream>("readInto", readInto);
+
+  AddProperty<Stream>("available", get_available);
+}
+
+Stream::Parameters Stream::ParseOptions(bool inflate,
+                                        const utilities::Options& options) {
+  Parameters parameters(inflate);
+
+  if (!inflate) {
+    parameters.level = options.GetInt32("level", Z_DEFAULT_COMPRESSION);
+    if (parameters.level < -1 || parameters.level > 9)
+      throw base::RangeError("Invalid argument: -1 <= level <= 9 required");
+
+    parameters.mem_level = options.GetInt32("memLevel", 8);
+    if (parameters.mem_level < 1 || parameters.mem_level > MAX_MEM_LEVEL)
+      throw base::RangeError("Invalid argument: 1 <= memLevel <= 9 required");
+
+    std::string strategy(options.GetString("strategy", "default"));
+    if (strategy == "default")
+      parameters.strategy = Z_DEFAULT_STRATEGY;
+    else if (strategy == "filtered")
+      parameters.strategy = Z_FILTERED;
+    else if (strategy == "huffman")
+      parameters.strategy = Z_HUFFMAN_ONLY;
+    else if (strategy == "rle")
+      parameters.strategy = Z_RLE;
+    else if (strategy == "fixed")
+      parameters.strategy = Z_FIXED;
+    else
+      throw base::TypeError("Invalid strategy: " + strategy);
+  }
+
+  int window_bits = options.GetInt32("windowBits", MAX_WBITS);
+  if (window_bits < 8 || window_bits > MAX_WBITS)
+    throw base::RangeError("Invalid argument: 8 <= windowBits <= 15 required");
+
+  /* zlib's deflate does not support a window of 256 bytes; it silently uses
+     512 bytes instead, which inflate then rejects unless told the same. */
+  if (window_bits == 8)
+    window_bits = 9;
+
+  std::string format(options.GetString("format", "zlib"));
+  if (format == "zlib")
+    parameters.window_bits = window_bits;
+  else if (format == "gzip")
+    parameters.window_bits = window_bits + 16;
+  else if (format == "raw")
+    parameters.window_bits = -window_bits;
+  else if (format == "auto" && inflate)
+    parameters.window_bits = window_bits + 32;
+  else
+    throw base::TypeError("Invalid format: " + format);
+
+  if (options.Has("dictionary")) {
+    builtin::Bytes::Value dictionary(
+        base::AsValue<builtin::Bytes::Value>(options.Get("dictionary")));
+    parameters.dictionary = dictionary;
+  }
+
+  return parameters;
 }
 
-builtin::Bytes::Instance* Stream::Deflate(builtin::Bytes::Instance* data,
-                                          int level) {
-  utilities::Anchor<Instance> instance(new Instance(level));
+builtin::Bytes::Value Stream::Deflate(builtin::Bytes::Value data,
+                                      const Parameters& parameters) {
+  utilities::Anchor<Instance> instance(new Instance(parameters));
 
   write(instance, data);
   close(instance);
 
-  return read(instance);
+  return read(instance, Optional<size_t>());
 }
 
-builtin::Bytes::Instance* Stream::Inflate(builtin::Bytes::Instance* data) {
-  utilities::Anchor<Instance> instance(
-      new Instance(std::numeric_limits<int>::min()));
+builtin::Bytes::Value Stream::Inflate(builtin::Bytes::Value data,
+                                      const Parameters& parameters) {
+  utilities::Anchor<Instance> instance(new Instance(parameters));
 
   write(instance, data);
   close(instance);
 
-  return read(instance);
+  return read(instance, Optional<size_t>());
 }
 
 Stream::Instance* Stream::constructor(Stream*, std::string type,
@@ -128,44 +300,63 @@ Stream::Instance* Stream::constructor(Stream*, std::string type,
   if (type != "inflate" && type != "deflate")
     throw base::SyntaxError("Stream type must be 'inflate' or 'deflate'");
 
-  int level;
-
-  if (type == "inflate")
-    level = std::numeric_limits<int>::min();
-  else {
-    level = options.GetInt32("level", -1);
-    if (level < -1 || level > 9)
-      throw base::RangeError("Invalid argument: -1 <= level <= 9 required");
-  }
-
-  return new Instance(level);
+  return new Instance(ParseOptions(type == "inflate", options));
 }
 
 namespace {
 
-void process(Stream::Instance* instance, std::string data, int flush) {
-  char output[16384];
+void process(Stream::Instance* instance, const void* data, size_t length,
+             int flush) {
+  const size_t kMaximumInput = std::numeric_limits<uInt>::max();
   int ret;
 
   instance->impl.next_in =
       reinterpret_cast<decltype(instance->impl.next_in)>(
-          const_cast<char*>(data.c_str()));
-  instance->impl.avail_in = data.length();
+          const_cast<void*>(data));
 
+  /* The input is fed to zlib straight from the caller's buffer, in pieces if
+     it is larger than what 'avail_in' can describe. */
   do {
-    instance->impl.next_out =
-        reinterpret_cast<decltype(instance->impl.next_out)>(output);
-    instance->impl.avail_out = sizeof output;
+    size_t piece = std::min(length, kMaximumInput);
+    int piece_flush = piece == length ? flush : Z_NO_FLUSH;
 
-    if (instance->is_inflate())
-      ret = inflate(&instance->impl, flush);
-    else
-      ret = deflate(&instance->impl, flush);
+    instance->impl.avail_in = piece;
+    length -= piece;
+
+    do {
+      Stream::Instance::Chunk& chunk = instance->WritableChunk();
+      size_t space = Stream::Instance::kChunkSize - chunk.end;
+
+      instance->impl.next_out =
+          reinterpret_cast<decltype(instance->impl.next_out)>(
+              chunk.data + chunk.end);
+      instance->impl.avail_out = space;
+
+      if (instance->is_inflate()) {
+        ret = inflate(&instance->impl, piece_flush);
+
+        if (ret == Z_NEED_DICT) {
+          if (instance->dictionary.empty())
+            throw Error("Dictionary required");
+
+          ret = inflateSetDictionary(
+              &instance->impl,
+              reinterpret_cast<const Bytef*>(instance->dictionary.data()),
+              instance->dictionary.length());
 
-    if (ret == Z_OK || ret == Z_STREAM_END)
-      instance->buffered += std::string(
-          output, sizeof output - instance->impl.avail_out);
-  } while (ret == Z_OK);
+          if (ret != Z_OK)
+            throw Error("Invalid dictionary");
+        }
+      } else {
+        ret = deflate(&instance->impl, piece_flush);
+      }
+
+      size_t produced = space - instance->impl.avail_out;
+
+      chunk.end += produced;
+      instance->available += produced;
+    } while (ret == Z_OK);
+  } while (length != 0 && (ret == Z_OK || ret == Z_BUF_ERROR));
 
   switch (ret) {
     case Z_STREAM_ERROR:
@@ -179,37 +370,95 @@ void process(Stream::Instance* instance, std::string data, int flush) {
 
 }
 
-void Stream::write(Instance* instance, builtin::Bytes::Instance* bytes) {
+std::string Stream::Compress(const std::string& data, int level,
+                             Format format) {
+  Parameters parameters(false);
+
+  parameters.level = level;
+
+  switch (format) {
+    case Format::kGZip:
+      parameters.window_bits += 16;
+      break;
+    case Format::kRaw:
+      parameters.window_bits = -parameters.window_bits;
+      break;
+    default:
+      break;
+  }
+
+  utilities::Anchor<Instance> instance(new Instance(parameters));
+
+  process(instance, data.data(), data.length(), Z_FINISH);
+  instance->close();
+
+  std::string result(instance->available, '\0');
+  instance->Consume(&result[0], result.length());
+  return result;
+}
+
+std::string Stream::Process(const Parameters& parameters, const void* data,
+                            size_t length) {
+  utilities::Anchor<Instance> instance(new Instance(parameters, false));
+
+  process(instance, data, length, Z_FINISH);
+  instance->close();
+
+  std::string result(instance->available, '\0');
+  instance->Consume(&result[0], result.length());
+  return result;
+}
+
+void Stream::write(Instance* instance, builtin::Bytes::Value bytes) {
   if (instance->closed)
     throw Error("Stream is closed");
 
-  process(instance, builtin::Bytes::data(bytes), Z_NO_FLUSH);
+  process(instance, bytes.data(), bytes.length(), Z_NO_FLUSH);
 }
 
 void Stream::flush(Instance* instance) {
   if (instance->closed)
     throw Error("Stream is closed");
 
-  process(instance, "", Z_SYNC_FLUSH);
+  process(instance, NULL, 0, Z_SYNC_FLUSH);
 }
 
 void Stream::close(Instance* instance) {
   if (!instance->closed) {
-    process(instance, "", Z_FINISH);
+    process(instance, NULL, 0, Z_FINISH);
     instance->close();
   }
 }
 
-builtin::Bytes::Instance* Stream::read(Instance* instance) {
-  if (instance->buffered.length() == 0)
-    return NULL;
+builtin::Bytes::Value Stream::read(Instance* instance,
+                                   Optional<size_t> nbytes) {
+  size_t length = instance->available;
 
-  builtin::Bytes::Instance* bytes =
-      builtin::Bytes::FromContext()->New(instance->buffered);
+  if (nbytes.specified())
+    length = std::min(length, nbytes.value());
 
-  instance->buffered = "";
+  if (length == 0)
+    return builtin::Bytes::Value();
+
+  builtin::Bytes::Value result(
+      builtin::Bytes::FromContext()->NewUninitialized(length));
+  instance->Consume(static_cast<char*>(result.data()), length);
+  return result;
+}
+
+std::int64_t Stream::readInto(Instance* instance, builtin::Bytes::Value target,
+                              Optional<size_t> offset_opt) {
+  size_t offset = offset_opt.value(0);
+
+  if (offset > target.length())
+    throw base::RangeError("offset out of range");
+
+  return instance->Consume(static_cast<char*>(target.data()) + offset,
+                           target.length() - offset);
+}
 
-  return bytes;
+std::int64_t Stream::get_available(Instance* instance) {
+  return instance->available;
 }
 
 }
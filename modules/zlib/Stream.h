@@ -36,21 +36,63 @@ class Stream : public api::Class {
  public:
   class Instance;
 
+  enum class Format {
+    kZLib,
+    kGZip,
+    kRaw,
+    kAuto
+  };
+
+  struct Parameters {
+    Parameters(bool inflate);
+
+    bool inflate;
+    int level;
+    int window_bits;
+    int mem_level;
+    int strategy;
+    std::string dictionary;
+  };
+
   Stream();
 
-  static builtin::Bytes::Instance* Deflate(builtin::Bytes::Instance* data,
-                                           int level);
-  static builtin::Bytes::Instance* Inflate(builtin::Bytes::Instance* data);
+  static Parameters ParseOptions(bool inflate,
+                                 const utilities::Options& options);
+  /**< Parse the "level", "format", "windowBits", "memLevel", "strategy" and
+       "dictionary" options shared by ZLib.Stream, ZLib.deflate() and
+       ZLib.inflate().  Throws on invalid values. */
+
+  static builtin::Bytes::Value Deflate(builtin::Bytes::Value data,
+                                       const Parameters& parameters);
+  static builtin::Bytes::Value Inflate(builtin::Bytes::Value data,
+                                       const Parameters& parameters);
+
+  static std::string Compress(const std::string& data, int level,
+                              Format format);
+  /**< Compress 'data' in one go, without involving any script objects.  Used
+       by other modules that need to compress data they own themselves. */
+
+  static std::string Process(const Parameters& parameters, const void* data,
+                             size_t length);
+  /**< Deflate or inflate 'data' in one go, without touching the isolate, so
+       that it can be called on a thread pool thread.  Throws zlib::Error on
+       failure. */
 
  private:
   static Instance* constructor(Stream*, std::string type,
                                utilities::Options options);
 
-  static void write(Instance* instance, builtin::Bytes::Instance* data);
+  static void write(Instance* instance, builtin::Bytes::Value data);
   static void flush(Instance* instance);
   static void close(Instance* instance);
 
-  static builtin::Bytes::Instance* read(Instance* instance);
+  static builtin::Bytes::Value read(Instance* instance,
+                                    Optional<size_t> nbytes);
+  static std::int64_t readInto(Instance* instance,
+                               builtin::Bytes::Value target,
+                               Optional<size_t> offset);
+
+  static std::int64_t get_available(Instance* instance);
 };
 
 }
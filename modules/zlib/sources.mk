@@ -15,6 +15,7 @@
 ifeq ($(zlib),yes)
 
 common_sources += modules/zlib/Stream.cc \
+                  modules/zlib/Parallel.cc \
                   modules/zlib/Error.cc
 defines += ZLIB_SUPPORT=1
 libraries += z
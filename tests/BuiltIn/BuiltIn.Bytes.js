@@ -0,0 +1,152 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+"use strict";
+
+setScope("BuiltIn.Bytes");
+
+test([
+  function () {
+    var bytes = Bytes.encode("Hello world!");
+    var slice = bytes.slice(6, 5);
+
+    assertTrue(slice instanceof Bytes);
+    assertEquals("world", slice.decode());
+
+    slice[0] = "W".charCodeAt(0);
+
+    assertEquals("Hello World!", bytes.decode());
+  },
+
+  function () {
+    var bytes = Bytes.encode("Hello world!");
+    var slice = bytes.slice(6).slice(1, 3);
+
+    assertEquals("orl", slice.decode());
+    assertEquals("", bytes.slice(100).decode());
+  },
+
+  function () {
+    var bytes = Bytes.encode("Hello world!");
+    var copy = bytes.copy(6, 5);
+
+    assertTrue(copy instanceof Bytes);
+    assertEquals("world", copy.decode());
+
+    copy[0] = "W".charCodeAt(0);
+
+    assertEquals("Hello world!", bytes.decode());
+    assertEquals("Hello world!", bytes.copy().decode());
+  },
+
+  function () {
+    var bytes = Bytes.encode("foobar");
+
+    assertEquals("666f6f626172", bytes.decode("hex"));
+    assertEquals("foobar", Bytes.encode("666F6F626172", "hex").decode());
+    assertThrows(TypeError, "invalid hex string: odd length",
+                 function () { Bytes.encode("666", "hex"); });
+  },
+
+  function () {
+    assertEquals("Zm9vYmE=", Bytes.encode("fooba").decode("base64"));
+    assertEquals("Zm9vYmE", Bytes.encode("fooba").decode("base64url"));
+    assertEquals("fooba", Bytes.encode("Zm9vYmE=", "base64").decode());
+    assertEquals("fooba", Bytes.encode("Zm9v\nYmE", "base64url").decode());
+
+    var binary = Bytes.encode("+/8=", "base64");
+
+    assertEquals("fbff", binary.decode("hex"));
+    assertEquals("-_8", binary.decode("base64url"));
+    assertThrows(TypeError, "invalid base64 string",
+                 function () { Bytes.encode("Zm9v*", "base64"); });
+  },
+
+  function () {
+    var latin1 = Bytes.encode("caf\u00e9", "latin1");
+
+    assertEquals(4, latin1.length);
+    assertEquals(0xe9, latin1[3]);
+    assertEquals("caf\u00e9", latin1.decode("latin1"));
+    assertFalse(latin1.isValidUTF8());
+
+    var utf8 = Bytes.encode("caf\u00e9");
+
+    assertEquals(5, utf8.length);
+    assertTrue(utf8.isValidUTF8());
+    assertEquals("caf\u00e9", utf8.decode());
+  },
+
+  function () {
+    var utf16 = Bytes.encode("a\ud83d\ude00", "utf-16le");
+
+    assertEquals("61003dd800de", utf16.decode("hex"));
+    assertEquals("a\ud83d\ude00", utf16.decode("utf-16le"));
+    assertEquals("a\ud83d\ude00", utf16.slice(1).copy(1).decode("utf-16le"));
+  },
+
+  function () {
+    var bytes = Bytes.encode("abc,def,,abc");
+
+    assertEquals(3, bytes.indexOf(0x2c));
+    assertEquals(7, bytes.indexOf(0x2c, 4));
+    assertEquals(-1, bytes.indexOf(0x12c));
+    assertEquals(9, bytes.indexOf("abc", 1));
+    assertEquals(9, bytes.lastIndexOf("abc"));
+    assertEquals(0, bytes.lastIndexOf("abc", 8));
+    assertEquals(8, bytes.lastIndexOf(0x2c));
+    assertEquals(-1, bytes.indexOf("xyz"));
+    assertEquals(3, bytes.count(0x2c));
+    assertEquals(2, bytes.count("abc"));
+  },
+
+  function () {
+    var bytes = Bytes.encode("abc,def,,abc");
+    var parts = bytes.split(",");
+
+    assertEquals(4, parts.length);
+    assertTrue(parts[0] instanceof Bytes);
+    assertEquals("abc|def||abc", parts.map(function (part) {
+        return part.decode();
+      }).join("|"));
+    assertEquals(2, bytes.split(0x2c, 2).length);
+  },
+
+  function () {
+    var lines = Bytes.encode("first\r\nsecond\n\nlast").lines();
+
+    assertEquals(4, lines.length);
+    assertEquals("first", lines[0].decode());
+    assertEquals("second", lines[1].decode());
+    assertEquals("", lines[2].decode());
+    assertEquals("last", lines[3].decode());
+    assertEquals(1, Bytes.encode("one\n").lines().length);
+  },
+
+  function () {
+    var before = Bytes.allocatorStatistics();
+    var bytes = new Bytes(100);
+    var after = Bytes.allocatorStatistics();
+
+    assertEquals(0, bytes[99]);
+    assertEquals(before.allocations["128"] + 1, after.allocations["128"]);
+    assertTrue(after.liveBytes >= before.liveBytes + 128);
+    assertEquals("number", typeof after.pooledBytes);
+  }
+]);
+
+endScope();
@@ -0,0 +1,82 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+"use strict";
+
+setScope("BuiltIn.BytesBuilder");
+
+test([
+  function () {
+    var builder = new BytesBuilder;
+
+    builder.append("Hello");
+    builder.append(Bytes.encode(" world"));
+    builder.appendUInt8(0x21);
+
+    assertEquals(12, builder.length);
+
+    var result = builder.finish();
+
+    assertTrue(result instanceof Bytes);
+    assertEquals("Hello world!", result.decode());
+    assertEquals(0, builder.length);
+  },
+
+  function () {
+    var builder = new BytesBuilder(4);
+
+    builder.appendUInt16LE(0x0102);
+    builder.appendUInt16BE(0x0102);
+    builder.appendUInt32LE(0x01020304);
+    builder.appendUInt32BE(0x01020304);
+
+    var result = builder.finish();
+
+    assertEquals("2,1,1,2,4,3,2,1,1,2,3,4", Array.prototype.join.call(result));
+  },
+
+  function () {
+    var builder = new BytesBuilder;
+
+    for (var index = 0; index < 10000; ++index)
+      builder.append("x");
+
+    assertEquals(10000, builder.length);
+    assertTrue(builder.capacity >= 10000);
+    assertEquals(10000, builder.finish().length);
+  },
+
+  function () {
+    /* A mostly unused buffer is copied rather than handed over. */
+    var builder = new BytesBuilder(4096);
+
+    builder.append("abc");
+
+    assertEquals("abc", builder.finish().decode());
+    assertEquals(0, builder.capacity);
+  },
+
+  function () {
+    var result = Bytes.concat(["Hello", Bytes.encode(" "), "world!"]);
+
+    assertTrue(result instanceof Bytes);
+    assertEquals("Hello world!", result.decode());
+    assertEquals(0, Bytes.concat([]).length);
+  }
+]);
+
+endScope();
@@ -0,0 +1,93 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("BuiltIn.EventLoop");
+
+test([
+  function () {
+    var order = [];
+
+    setTimeout(function (value) { order.push(value); }, 20, "second");
+    setTimeout(function (value) { order.push(value); }, 0, "first");
+    clearTimeout(setTimeout(function () { order.push("cleared"); }, 10));
+
+    var count = 0;
+    var interval = setInterval(function () {
+      if (++count == 3)
+        clearInterval(interval);
+    }, 1);
+
+    runEventLoop();
+
+    assertEquals(["first", "second"], order);
+    assertEquals(3, count);
+  },
+
+  function () {
+    /* Promise reactions run between callbacks. */
+    var order = [];
+
+    setTimeout(function () {
+      Promise.resolve().then(function () { order.push("microtask"); });
+      order.push("timeout");
+    }, 0);
+    setTimeout(function () { order.push("next"); }, 0);
+
+    runEventLoop();
+
+    assertEquals(["timeout", "microtask", "next"], order);
+  },
+
+  function () {
+    var pipe = new IO.Pipe();
+    var received = null;
+
+    var id = watch(pipe.input, "read", function (ready) {
+      assertTrue(ready.read);
+      received = pipe.input.read(4).decode();
+      unwatch(id);
+    });
+
+    setTimeout(function () { pipe.output.write("data"); }, 10);
+
+    runEventLoop();
+
+    assertEquals("data", received);
+
+    pipe.input.close();
+    pipe.output.close();
+  },
+
+  function () {
+    var process = new OS.Process("exit 3", { shell: true });
+    var status = null;
+
+    process.start();
+    process.waitAsync().then(function (process) {
+      status = process.exitStatus;
+    });
+
+    runEventLoop();
+
+    assertEquals(3, status);
+  }
+]);
+
+endScope();
@@ -0,0 +1,64 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("BuiltIn.ThreadPool");
+
+test([
+  function () {
+    var path = "tests/input/repetetive.txt";
+    var results = {};
+
+    IO.File.readAsync(path).then(function (data) {
+      results.data = data;
+    });
+    IO.File.readAsync("tests/input/nonexistent").catch(function (error) {
+      results.error = error;
+    });
+    Hash.digestAsync("sha1", "abc").then(function (digest) {
+      results.digest = digest;
+    });
+    IO.SocketAddress.internetAsync("127.0.0.1", 8080).then(function (address) {
+      results.address = address;
+    });
+
+    runEventLoop();
+
+    assertEquals(IO.File.read(path).decode(), results.data.decode());
+    assertEquals("IOError", results.error.name);
+    assertEquals("a9993e364706816aba3e25717850c26c9cd0d89d",
+                 results.digest.decode("hex"));
+    assertEquals("127.0.0.1", results.address.internet.address);
+    assertEquals(8080, results.address.internet.port);
+
+    assertThrows(TypeError, "unsupported algorithm: md5",
+                 function () { Hash.digestAsync("md5", "abc"); });
+  },
+
+  function () {
+    var statistics = threadPoolStatistics();
+
+    assertTrue(statistics.threads >= 2);
+    assertEquals(0, statistics.queued);
+    assertTrue(statistics.completed >= 4);
+    assertTrue(statistics.maxWait <= statistics.totalWait);
+  }
+]);
+
+endScope();
@@ -19,3 +19,7 @@
 Module.load("BuiltIn.format.js");
 Module.load("BuiltIn.scoped.js");
 Module.load("BuiltIn.Module.js");
+Module.load("BuiltIn.Bytes.js");
+Module.load("BuiltIn.BytesBuilder.js");
+Module.load("BuiltIn.EventLoop.js");
+Module.load("BuiltIn.ThreadPool.js");
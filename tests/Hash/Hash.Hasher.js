@@ -0,0 +1,54 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+"use strict";
+
+setScope("Hash.Hasher");
+
+test([
+  function () {
+    var input = IO.File.read("tests/input/repetetive.txt");
+
+    ["sha1", "sha256", "xxh64"].forEach(function (algorithm) {
+      var hasher = new Hash.Hasher(algorithm);
+
+      for (var offset = 0; offset < input.length; offset += 100)
+        hasher.update(input.slice(offset, 100));
+
+      assertEquals(algorithm, hasher.algorithm);
+      assertEquals(Hash[algorithm](input).decode("hex"),
+                   hasher.digest().decode("hex"));
+      assertThrows(TypeError, "digest already computed",
+                   function () { hasher.update("more"); });
+    });
+  },
+
+  function () {
+    var hasher = new Hash.Hasher("xxh64", { seed: 1 });
+
+    hasher.update("abc");
+
+    assertEquals(Hash.xxh64("abc", 1).decode("hex"),
+                 hasher.digest().decode("hex"));
+    assertTrue(Hash.xxh64("abc", 1).decode("hex") !=
+               Hash.xxh64("abc").decode("hex"));
+    assertThrows(TypeError, "unsupported algorithm: md5",
+                 function () { new Hash.Hasher("md5"); });
+  }
+]);
+
+endScope();
@@ -0,0 +1,45 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+"use strict";
+
+Module.load("Hash.Hasher.js");
+
+setScope("Hash");
+
+test([
+  function () {
+    assertEquals("a9993e364706816aba3e25717850c26c9cd0d89d",
+                 Hash.sha1("abc").decode("hex"));
+    assertEquals("ba7816bf8f01cfea414140de5dae2223" +
+                 "b00361a396177a9cb410ff61f20015ad",
+                 Hash.sha256("abc").decode("hex"));
+    assertEquals("44bc2cf5ad770999", Hash.xxh64("abc").decode("hex"));
+    assertEquals("ef46db3751d8e999", Hash.xxh64("").decode("hex"));
+  },
+
+  function () {
+    /* echo -n "hello world" | git hash-object --stdin */
+    assertEquals("95d09f2b10159347eece71399a7e2e907ea3df4f",
+                 Hash.gitObjectId("hello world"));
+    /* git mktree < /dev/null */
+    assertEquals("4b825dc642cb6eb9a060e54bf8d69288fbee4904",
+                 Hash.gitObjectId("", "tree"));
+  }
+]);
+
+endScope();
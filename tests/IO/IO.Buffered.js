@@ -56,6 +56,99 @@ test([
     assertEquals(null, buffered.readln());
 
     process.wait();
+  },
+
+  function () {
+    /* A final line without a trailing newline is still returned. */
+    IO.File.write("tests/output/buffered.txt", "First\r\nSecond\r\nLast");
+
+    scoped(new IO.File("tests/output/buffered.txt"), function () {
+      var buffered = new IO.Buffered(this, { delimiter: "\r\n" });
+
+      assertEquals("First", buffered.readln());
+      assertEquals("Second", buffered.readln());
+      assertEquals("Last", buffered.readln());
+      assertEquals(null, buffered.readln());
+    });
+  },
+
+  function () {
+    /* Lines longer than the buffer, and binary mode. */
+    var long = new Array(101).join("x");
+
+    IO.File.write("tests/output/buffered.txt", long + "\n" + long + "\n");
+
+    scoped(new IO.File("tests/output/buffered.txt"), function () {
+      var buffered = new IO.Buffered(this, { bufferSize: 16, binary: true });
+      var line = buffered.readln();
+
+      assertTrue(line instanceof Bytes);
+      assertEquals(long, line.decode());
+      assertEquals(10, buffered.read(10).length);
+      assertEquals(91, buffered.read().length);
+    });
+  },
+
+  function () {
+    scoped(new IO.File("tests/input/lines.txt"), function () {
+      var buffered = new IO.Buffered(this);
+
+      assertEquals(["First line", "Second line"], buffered.readLines(2));
+      assertEquals(["Third line"], buffered.readLines());
+      assertEquals([], buffered.readLines());
+    });
+
+    scoped(new IO.File("tests/input/lines.txt"), function () {
+      var buffered = new IO.Buffered(this);
+
+      /* The line that reaches the byte limit is included. */
+      assertEquals(["First line", "Second line"],
+                   buffered.readLines({ maxBytes: 12 }));
+
+      [0, -1, NaN, Infinity].forEach(function (limit) {
+        assertThrows(RangeError, "invalid limit; must be a finite number >= 1",
+                     function () { buffered.readLines(limit); });
+        assertThrows(RangeError, "invalid limit; must be a finite number >= 1",
+                     function () { buffered.readLines({ maxBytes: limit }); });
+      });
+    });
+  },
+
+  function () {
+    scoped(new IO.File("tests/input/lines.txt"), function () {
+      var lines = [];
+
+      for (var line of new IO.Buffered(this))
+        lines.push(line);
+
+      assertEquals(["First line", "Second line", "Third line"], lines);
+    });
+  },
+
+  function () {
+    /* Reading everything from a non-blocking file that has no more data for
+       now isn't end-of-file. */
+    var pipe = new IO.Pipe();
+    var buffered = new IO.Buffered(pipe.input);
+
+    pipe.input.setBlocking(false);
+    pipe.output.write("abc");
+
+    assertEquals("abc", buffered.read().decode());
+
+    pipe.output.write("more\n");
+    pipe.output.close();
+    pipe.input.setBlocking(true);
+
+    assertEquals("more", buffered.readln());
+    assertEquals(null, buffered.readln());
+
+    pipe.input.close();
+  },
+
+  function () {
+    assertThrows(TypeError, "invalid delimiter; must not be empty",
+                 function () { new IO.Buffered(0, { delimiter: "" }); });
   }
 ]);
 
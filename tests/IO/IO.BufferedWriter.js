@@ -0,0 +1,78 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.BufferedWriter");
+
+test([
+  function () {
+    var path = "tests/output/bufferedwriter.txt";
+
+    scoped(new IO.File(path, "w"), function () {
+      var writer = new IO.BufferedWriter(this, { size: 16 });
+
+      writer.write("Hello");
+      writer.writeln(" world!");
+      assertEquals(13, writer.buffered);
+      assertEquals("", IO.File.read(path).decode());
+
+      writer.flush();
+      assertEquals(0, writer.buffered);
+      assertEquals("Hello world!\n", IO.File.read(path).decode());
+
+      /* Writes that don't fit are written straight away, together with
+         what was buffered before them. */
+      writer.write("abc");
+      writer.write("0123456789abcdefghij");
+      assertEquals(0, writer.buffered);
+      assertEquals("Hello world!\nabc0123456789abcdefghij",
+                   IO.File.read(path).decode());
+
+      writer.write("end");
+      writer.close();
+      assertTrue(writer.closed);
+      assertEquals("Hello world!\nabc0123456789abcdefghijend",
+                   IO.File.read(path).decode());
+
+      assertThrows(TypeError, "writer closed",
+                   function () { writer.write("more"); });
+    });
+  },
+
+  function () {
+    var path = "tests/output/bufferedwriter.txt";
+
+    /* Writing used to write the start of the data repeatedly after a
+       partial write; large writes exercise that path through pipes. */
+    var data = new Array(200001).join("x");
+    var pipe = new IO.Pipe();
+    var process = new OS.Process("cat > " + path, { shell: true });
+
+    process.stdin = pipe.input;
+    process.start();
+
+    pipe.output.write(data);
+    pipe.output.close();
+    process.wait();
+
+    assertEquals(data, IO.File.read(path).decode());
+  }
+]);
+
+endScope();
@@ -0,0 +1,54 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.File.copy");
+
+test([
+  function () {
+    var source = "tests/input/repetetive.txt";
+    var target = "tests/output/copy.txt";
+
+    assertEquals(IO.File.stat(source).size, IO.File.copy(source, target));
+    assertEquals(IO.File.read(source).decode(), IO.File.read(target).decode());
+  },
+
+  function () {
+    /* Copying to a pipe and from a pipe to a file. */
+    var source = "tests/input/repetetive.txt";
+    var target = "tests/output/splice.txt";
+    var size = IO.File.stat(source).size;
+    var pipe = new IO.Pipe();
+
+    scoped(new IO.File(source), function () {
+      assertEquals(size, IO.splice(this, pipe.output));
+    });
+    pipe.output.close();
+
+    scoped(new IO.File(target, "w"), function () {
+      assertEquals(100, IO.splice(pipe.input, this, 100));
+      assertEquals(size - 100, IO.splice(pipe.input, this));
+    });
+    pipe.input.close();
+
+    assertEquals(IO.File.read(source).decode(), IO.File.read(target).decode());
+  }
+]);
+
+endScope();
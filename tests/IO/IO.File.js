@@ -20,3 +20,8 @@
 
 Module.load("IO.File.utimes.js");
 Module.load("IO.File.setCloseOnExec.js");
+Module.load("IO.File.read.js");
+Module.load("IO.File.map.js");
+Module.load("IO.File.copy.js");
+Module.load("IO.File.walk.js");
+Module.load("IO.File.statMany.js");
@@ -0,0 +1,67 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.File.map");
+
+test([
+  function () {
+    var path = "tests/input/repetetive.txt";
+    var expected = IO.File.read(path).decode();
+    var mapped = IO.File.map(path);
+
+    assertEquals(expected.length, mapped.length);
+    assertEquals(expected, mapped.decode());
+  },
+
+  function () {
+    var path = "tests/input/repetetive.txt";
+    var expected = IO.File.read(path).decode();
+    var mapped = IO.File.map(path, { offset: 1000, length: 100 });
+
+    assertEquals(100, mapped.length);
+    assertEquals(expected.substring(1000, 1100), mapped.decode());
+
+    mapped = IO.File.map(path, { offset: expected.length });
+    assertEquals(0, mapped.length);
+  },
+
+  function () {
+    /* The mapping is private: modifying it must not modify the file. */
+    IO.File.write("tests/output/map.txt", "Hello world!\n");
+
+    var mapped = IO.File.map("tests/output/map.txt");
+    mapped[0] = 74;
+
+    assertEquals("Jello world!\n", mapped.decode());
+    assertEquals("Hello world!\n", IO.File.read("tests/output/map.txt").decode());
+  },
+
+  function () {
+    var path = "tests/input/repetetive.txt";
+    var size = IO.File.stat(path).size;
+
+    assertThrows(RangeError, "offset out of range",
+                 function () { IO.File.map(path, { offset: size + 1 }); });
+    assertThrows(RangeError, "length out of range",
+                 function () { IO.File.map(path, { offset: 1, length: size }); });
+  }
+]);
+
+endScope();
@@ -0,0 +1,71 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.File.read");
+
+test([
+  function () {
+    var path = "tests/input/repetetive.txt";
+    var expected = IO.File.read(path).decode();
+    var file = new IO.File(path);
+
+    assertEquals(IO.File.stat(path).size, expected.length);
+    assertEquals(expected.substring(0, 10), file.read(10).decode());
+    assertEquals(expected.substring(10), file.read().decode());
+    assertEquals(undefined, file.read());
+
+    file.close();
+  },
+
+  function () {
+    var path = "tests/input/repetetive.txt";
+    var expected = IO.File.read(path).decode();
+    var file = new IO.File(path);
+    var buffer = new Bytes(100);
+
+    assertEquals(90, file.readInto(buffer, 10));
+    assertEquals(expected.substring(0, 90), buffer.slice(10).decode());
+
+    var total = 90, nread;
+    while ((nread = file.readInto(buffer)) != 0)
+      total += nread;
+    assertEquals(expected.length, total);
+
+    assertThrows(RangeError, "offset out of range",
+                 function () { file.readInto(buffer, 101); });
+
+    file.close();
+  },
+
+  function () {
+    /* Files whose size isn't known from fstat() are read in full too. */
+    var pipe = new IO.Pipe();
+    var data = IO.File.read("tests/input/repetetive.txt");
+
+    pipe.output.write(data);
+    pipe.output.close();
+
+    assertEquals(data.decode(), pipe.input.read().decode());
+
+    pipe.input.close();
+  }
+]);
+
+endScope();
@@ -0,0 +1,85 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.File.statMany");
+
+test([
+  function () {
+    var paths = ["tests/input/helloworld.txt", "tests/input/nonexistent",
+                 "tests/input"];
+    var result = IO.File.statMany(paths);
+    var stat = IO.File.stat(paths[0]);
+
+    assertEquals(3, result.size.length);
+    assertEquals(stat.size, result.size[0]);
+    assertEquals(stat.mtime.getTime(), Math.floor(result.mtime[0]));
+    assertEquals(stat.mode, result.mode[0]);
+    assertEquals(0, result.error[0]);
+    assertEquals(2 /* ENOENT */, result.error[1]);
+    assertEquals(0o040000, result.mode[2] & 0o170000);
+
+    var parallel = IO.File.statMany(paths, { parallel: 2 });
+
+    assertEquals(Array.from(result.size), Array.from(parallel.size));
+    assertEquals(Array.from(result.error), Array.from(parallel.error));
+
+    var relative = IO.File.statMany(["helloworld.txt"],
+                                    { directory: "tests/input" });
+
+    assertEquals(stat.size, relative.size[0]);
+  },
+
+  function () {
+    var path = "tests/output/statcache.txt";
+
+    IO.File.setStatCache({ ttl: 60000 });
+
+    try {
+      IO.File.write(path, "12345");
+      assertEquals(5, IO.File.stat(path).size);
+
+      /* Writes through IO.File invalidate the cached entry. */
+      IO.File.write(path, "1234567890");
+      assertEquals(10, IO.File.stat(path).size);
+      assertEquals(10, IO.File.statMany([path]).size[0]);
+
+      /* So do writes through IO.batch(). */
+      IO.batch([{ op: "write", path: path, data: "123" }]);
+      assertEquals(3, IO.File.stat(path).size);
+
+      IO.File.unlink(path);
+      assertFalse(IO.File.isRegularFile(path));
+      assertEquals(2, IO.File.statMany([path]).error[0]);
+    } finally {
+      IO.File.setStatCache();
+    }
+  },
+
+  function () {
+    assertTrue(IO.File.isDirectory("tests/input"));
+    assertFalse(IO.File.isDirectory("tests/input/lines.txt"));
+    assertTrue(IO.File.stat("tests/input").isDirectory());
+    assertFalse(IO.File.stat("/dev/null").isDirectory());
+    assertFalse(IO.File.stat("/dev/null").isBlockDevice());
+    assertTrue(IO.File.stat("/dev/null").isCharacterDevice());
+  }
+]);
+
+endScope();
@@ -0,0 +1,111 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.File.walk");
+
+function makeTree() {
+  var root = "tests/output/walk";
+
+  ["", "/a", "/a/b", "/c"].forEach(function (path) {
+    if (!IO.File.isDirectory(root + path))
+      IO.File.mkdir(root + path);
+  });
+
+  ["/x.txt", "/a/y.txt", "/a/b/z.js", "/c/w.txt"].forEach(function (path) {
+    IO.File.write(root + path, "contents");
+  });
+
+  return root;
+}
+
+test([
+  function () {
+    var listing = IO.File.listDirectory("tests/input", { withTypes: true });
+    var names = listing.names.slice().sort();
+
+    assertEquals(["helloworld.txt", "lines.txt", "repetetive.txt"], names);
+    assertEquals("fff", listing.types);
+
+    assertTrue(IO.File.listDirectory("tests/input").indexOf("..") != -1);
+  },
+
+  function () {
+    var root = makeTree();
+    var expected = [root + "/a", root + "/a/b", root + "/a/b/z.js",
+                    root + "/a/y.txt", root + "/c", root + "/c/w.txt",
+                    root + "/x.txt"];
+
+    assertEquals(expected, IO.File.walk(root).sort());
+    assertEquals(expected, IO.File.walk(root, { parallel: 4 }).sort());
+    assertEquals(expected, IO.File.walk(root + "/").sort());
+  },
+
+  function () {
+    var root = makeTree();
+
+    assertEquals([root + "/a/y.txt", root + "/c/w.txt", root + "/x.txt"],
+                 IO.File.walk(root, { filter: "*.txt" }).sort());
+    assertEquals([root + "/a/b", root + "/a/b/z.js", root + "/a/y.txt"],
+                 IO.File.walk(root, { filter: ["a/*", "*.js"] }).sort());
+
+    var walked = IO.File.walk(root, { filter: "c*", withTypes: true });
+
+    assertEquals([root + "/c"], walked.paths);
+    assertEquals("d", walked.types);
+  },
+
+  function () {
+    var root = makeTree();
+    var result = null;
+
+    IO.File.walkAsync(root, { filter: "*.js" }).then(function (paths) {
+      result = paths;
+    });
+
+    runEventLoop();
+
+    assertEquals([root + "/a/b/z.js"], result);
+
+    assertThrows(Object, "open() failed: No such file or directory: " +
+                 "tests/output/nonexistent",
+                 function () { IO.File.walk("tests/output/nonexistent"); });
+  },
+
+  function () {
+    /* Parallel walks run on pool threads themselves, and more of them than
+       there are pool threads must not deadlock. */
+    var root = makeTree();
+    var expected = IO.File.walk(root).sort();
+    var count = threadPoolStatistics().threads * 2;
+    var results = [];
+
+    for (var index = 0; index < count; ++index)
+      IO.File.walkAsync(root, { parallel: 4 }).then(function (paths) {
+        results.push(paths.sort());
+      });
+
+    runEventLoop();
+
+    assertEquals(count, results.length);
+    results.forEach(function (paths) { assertEquals(expected, paths); });
+  }
+]);
+
+endScope();
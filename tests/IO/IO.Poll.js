@@ -0,0 +1,107 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.Poll");
+
+test([
+  function () {
+    var pipe = new IO.Pipe();
+    var poll = new IO.Poll();
+
+    poll.register(pipe.input, "read");
+    poll.register(pipe.output, "write");
+
+    assertTrue(poll.poll(0));
+    assertEquals([], poll.read);
+    assertEquals([pipe.output], poll.write);
+
+    pipe.output.write("data");
+
+    assertTrue(poll.poll(0));
+    assertEquals([pipe.input], poll.read);
+
+    poll.modify(pipe.output, "read");
+    poll.unregister(pipe.input);
+
+    assertFalse(poll.poll(0));
+    assertEquals([], poll.read);
+    assertEquals([], poll.write);
+
+    poll.clear();
+    assertTrue(poll.isEmpty());
+
+    pipe.input.close();
+    pipe.output.close();
+  },
+
+  function () {
+    /* Regular files can't be waited for, but are always ready. */
+    scoped(new IO.File("tests/input/lines.txt"), function () {
+      var poll = new IO.Poll();
+
+      poll.register(this, "read");
+
+      assertTrue(poll.poll());
+      assertEquals([this], poll.read);
+    });
+  },
+
+  function () {
+    /* With edge triggering, data that was already reported isn't reported
+       again until more arrives. */
+    var pipe = new IO.Pipe();
+    var poll = new IO.Poll({ maxEvents: 1 });
+
+    poll.register(pipe.input.fileno(), "read", { edgeTriggered: true });
+    pipe.output.write("data");
+
+    assertTrue(poll.poll(0));
+    assertEquals([pipe.input.fileno()], poll.read);
+    assertFalse(poll.poll(0));
+
+    pipe.output.write("more");
+    assertTrue(poll.poll(0));
+
+    pipe.input.close();
+    pipe.output.close();
+  },
+
+  function () {
+    /* A file descriptor closed while registered is reported as ready instead
+       of being waited for forever. */
+    var pipe = new IO.Pipe();
+    var poll = new IO.Poll();
+    var fileno = pipe.input.fileno();
+
+    poll.register(fileno, "read");
+    pipe.input.close();
+
+    assertTrue(poll.poll());
+    assertEquals([fileno], poll.read);
+    assertEquals([], poll.write);
+
+    poll.unregister(fileno);
+    assertTrue(poll.isEmpty());
+
+    pipe.output.close();
+  }
+]);
+
+endScope();
@@ -0,0 +1,115 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.Socket.async");
+
+function connectedPair() {
+  var address = IO.SocketAddress.unix("tests/output/async.unix");
+
+  if (IO.File.isSocket("tests/output/async.unix"))
+    IO.File.unlink("tests/output/async.unix");
+
+  var listening = new IO.Socket("unix", "stream");
+
+  listening.bind(address);
+  listening.listen(1);
+
+  var client = new IO.Socket("unix", "stream");
+
+  client.connect(address);
+
+  var server = listening.accept();
+
+  listening.close();
+
+  return [client, server];
+}
+
+test([
+  function () {
+    /* Operations in both directions can be pending at the same time. */
+    var pair = connectedPair(), client = pair[0], server = pair[1];
+    var received = [];
+
+    client.recvAsync(4).then(function (data) {
+      received.push(data.decode());
+    });
+    client.recvAsync(4).then(function (data) {
+      received.push(data.decode());
+    });
+    client.sendAsync("ping").then(function () {
+      assertEquals("ping", server.recv(4).decode());
+      server.send("pong");
+      server.send("pang");
+    });
+
+    runEventLoop();
+
+    assertEquals(["pong", "pang"], received);
+
+    client.close();
+    server.close();
+  },
+
+  function () {
+    /* Closing a socket rejects its pending operations, and doesn't leave
+       the event loop waiting for them. */
+    var pair = connectedPair(), client = pair[0], server = pair[1];
+    var error = null;
+
+    client.recvAsync(10).then(null, function (reason) { error = reason; });
+    client.close();
+
+    runEventLoop();
+
+    assertEquals("file descriptor closed", error.message);
+
+    /* A new socket likely gets the same file descriptor; watching it must
+       work. */
+    pair = connectedPair();
+    pair[1].send("data");
+    pair[0].recvAsync(4).then(function (data) { error = data.decode(); });
+
+    runEventLoop();
+
+    assertEquals("data", error);
+
+    pair[0].close();
+    pair[1].close();
+    server.close();
+  },
+
+  function () {
+    /* Likewise for watched files. */
+    var pipe = new IO.Pipe();
+    var called = false;
+
+    watch(pipe.input, "read", function () { called = true; });
+    pipe.input.close();
+
+    runEventLoop();
+
+    assertFalse(called);
+
+    pipe.output.close();
+  }
+]);
+
+endScope();
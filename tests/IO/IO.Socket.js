@@ -19,3 +19,5 @@
 "use strict";
 
 Module.load("IO.Socket.sendfd.js");
+Module.load("IO.Socket.sendFile.js");
+Module.load("IO.Socket.async.js");
@@ -0,0 +1,196 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.Watcher");
+
+function makeDirectory(path) {
+  if (!IO.File.isDirectory(path))
+    IO.File.mkdir(path);
+  return path;
+}
+
+function paths(changes) {
+  return changes.map(function (change) { return change.path; });
+}
+
+test([
+  function () {
+    var root = makeDirectory("tests/output/watch");
+    var watcher = new IO.Watcher();
+
+    watcher.add(root + "/");
+    assertEquals(1, watcher.watching);
+    assertEquals([], watcher.read());
+
+    /* A burst of events for one file is reported as a single change. */
+    IO.File.write(root + "/a.txt", "first");
+    IO.File.write(root + "/a.txt", "second");
+
+    var changes = watcher.read();
+
+    assertEquals([root + "/a.txt"], paths(changes));
+    assertTrue(changes[0].created);
+    assertTrue(changes[0].modified);
+    assertFalse(changes[0].deleted);
+    assertFalse(changes[0].directory);
+
+    IO.File.unlink(root + "/a.txt");
+
+    changes = watcher.read();
+
+    assertEquals([root + "/a.txt"], paths(changes));
+    assertFalse(changes[0].created);
+    assertTrue(changes[0].deleted);
+
+    watcher.remove(root);
+    assertEquals(0, watcher.watching);
+
+    watcher.close();
+    assertTrue(watcher.closed);
+    assertThrows(TypeError, "watcher closed", function () { watcher.read(); });
+  },
+
+  function () {
+    /* The watcher can be waited for along with other files. */
+    var root = makeDirectory("tests/output/watch");
+    var watcher = new IO.Watcher();
+    var poll = new IO.Poll();
+
+    watcher.add(root);
+    poll.register(watcher, "read");
+
+    assertFalse(poll.poll(0));
+
+    IO.File.write(root + "/b.txt", "contents");
+
+    assertTrue(poll.poll(0));
+    assertEquals([watcher], poll.read);
+    assertEquals([root + "/b.txt"], paths(watcher.read()));
+    assertFalse(poll.poll(0));
+    assertEquals([], watcher.read(10));
+
+    IO.File.unlink(root + "/b.txt");
+    watcher.close();
+  },
+
+  function () {
+    var root = makeDirectory("tests/output/watch");
+    var watcher = new IO.Watcher();
+
+    makeDirectory(root + "/a");
+    makeDirectory(root + "/a/b");
+
+    watcher.add(root, { recursive: true });
+    assertEquals(3, watcher.watching);
+
+    IO.File.write(root + "/a/b/c.txt", "contents");
+    assertEquals([root + "/a/b/c.txt"], paths(watcher.read()));
+
+    /* Directories moved into the tree are watched under their new path. */
+    IO.File.rename(root + "/a", root + "/d");
+
+    var changes = watcher.read();
+
+    assertEquals([root + "/a", root + "/d", root + "/d/b", root + "/d/b/c.txt"],
+                 paths(changes));
+    assertTrue(changes[0].deleted);
+    assertTrue(changes[1].created);
+    assertTrue(changes[1].directory);
+
+    IO.File.write(root + "/d/b/c.txt", "more");
+    assertEquals([root + "/d/b/c.txt"], paths(watcher.read()));
+
+    IO.File.unlink(root + "/d/b/c.txt");
+    IO.File.rename(root + "/d", root + "/a");
+    watcher.close();
+  },
+
+  function () {
+    /* With a coalescing delay, read() waits until the watched files have
+       been quiet for that long. */
+    var root = makeDirectory("tests/output/watch");
+    var watcher = new IO.Watcher({ coalesce: 50 });
+    var changes = null;
+
+    watcher.add(root);
+
+    var id = watch(watcher, "read", function () {
+      var before = Date.now();
+      changes = watcher.read();
+      assertTrue(Date.now() - before >= 40);
+      unwatch(id);
+    });
+
+    IO.File.write(root + "/e.txt", "first");
+    IO.File.write(root + "/e.txt", "second");
+
+    runEventLoop();
+
+    assertEquals([root + "/e.txt"], paths(changes));
+
+    IO.File.unlink(root + "/e.txt");
+    watcher.close();
+
+    assertThrows(RangeError, "invalid coalesce delay; must be non-negative",
+                 function () { new IO.Watcher({ coalesce: -1 }); });
+  },
+
+  function () {
+    /* Changes seen by a watcher invalidate cached stat() results, including
+       changes made through open files, which the cache can't see itself. */
+    var root = makeDirectory("tests/output/watch");
+    var watcher = new IO.Watcher();
+
+    IO.File.setStatCache({ ttl: 60000 });
+    watcher.add(root);
+
+    scoped(new IO.File(root + "/f.txt", "w"), function () {
+      assertEquals(0, IO.File.stat(root + "/f.txt").size);
+      this.write("abc");
+    });
+
+    watcher.read();
+    assertEquals(3, IO.File.stat(root + "/f.txt").size);
+
+    IO.File.unlink(root + "/f.txt");
+    IO.File.setStatCache({ ttl: 0 });
+    watcher.close();
+  },
+
+  function () {
+    /* Closing a watcher ends watches on it, so the loop doesn't wait for it
+       or call back with a stale descriptor. */
+    var root = makeDirectory("tests/output/watch");
+    var watcher = new IO.Watcher();
+    var called = false;
+
+    watcher.add(root);
+    watch(watcher, "read", function () { called = true; });
+    watcher.close();
+
+    IO.File.write(root + "/g.txt", "abc");
+    runEventLoop();
+
+    assertFalse(called);
+    IO.File.unlink(root + "/g.txt");
+  }
+]);
+
+endScope();
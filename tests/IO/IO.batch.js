@@ -0,0 +1,70 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+"use strict";
+
+setScope("IO.batch");
+
+function checkBatch(backend) {
+  var source = "tests/input/repetetive.txt";
+  var target = "tests/output/batch-" + backend + ".txt";
+  var data = IO.File.read(source);
+
+  var results = IO.batch([{ op: "read", path: source },
+                          { op: "stat", path: source },
+                          { op: "read", path: "tests/input/nonexistent" },
+                          { op: "write", path: target, data: data },
+                          { op: "lstat", path: "tests/input" }],
+                         { backend: backend });
+
+  assertEquals(5, results.length);
+  assertEquals(IO.File.read(source).decode(), results[0].decode());
+  assertEquals(IO.File.stat(source).size, results[1].size);
+  assertTrue(results[2] instanceof Error);
+  assertEquals("IOError", results[2].name);
+  assertEquals(undefined, results[3]);
+  assertEquals(data.decode(), IO.File.read(target).decode());
+  assertTrue(results[4].isDirectory());
+}
+
+test([
+  function () {
+    checkBatch("auto");
+  },
+
+  function () {
+    checkBatch("threads");
+  },
+
+  function () {
+    assertEquals(0, IO.batch([]).length);
+  },
+
+  function () {
+    assertThrows(TypeError, "invalid operation: remove",
+                 function () {
+                   IO.batch([{ op: "remove", path: "tests/output" }]);
+                 });
+    assertThrows(TypeError, "invalid backend option: aio",
+                 function () {
+                   IO.batch([], { backend: "aio" });
+                 });
+  }
+]);
+
+endScope();
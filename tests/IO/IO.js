@@ -20,5 +20,9 @@
 
 Module.load("IO.File.js");
 Module.load("IO.Buffered.js");
+Module.load("IO.BufferedWriter.js");
 Module.load("IO.Socket.js");
+Module.load("IO.Poll.js");
 Module.load("IO.Path.js");
+Module.load("IO.batch.js");
+Module.load("IO.Watcher.js");
@@ -45,7 +45,8 @@ HTTPServer.prototype.start = function () {
       var data = client.recv(4096);
       if (data === null)
         break;
-      buffered += data.decode();
+      /* Decoded byte by byte, so that a compressed body survives. */
+      buffered += data.decode("latin1");
     }
 
     var match = /(?:\r?\n){2}/.exec(buffered);
@@ -78,16 +79,21 @@ HTTPServer.prototype.start = function () {
           var data = client.recv(4096);
           if (data === null)
             break;
-          body += data.decode();
+          body += data.decode("latin1");
         }
       } else {
         while (true) {
           var data = client.recv(4096);
           if (data === null)
             break;
-          body += data.decode();
+          body += data.decode("latin1");
         }
       }
+
+      body = Bytes.encode(body, "latin1");
+      if ("Content-Encoding" in headers)
+        body = ZLib.inflate(body, { format: "auto" });
+      body = body.decode();
     }
 
     if (url == "/secret/basic" &&
@@ -106,6 +112,12 @@ HTTPServer.prototype.start = function () {
     } else if (url == "/error") {
       client.send("HTTP/1.0 404 Not Found\r\n");
       client.send("\r\n");
+    } else if (url == "/gzipped") {
+      client.send("HTTP/1.0 200 OK\r\n");
+      client.send("Content-Type: text/plain\r\n");
+      client.send("Content-Encoding: gzip\r\n");
+      client.send("\r\n");
+      client.send(ZLib.deflate("Hello world!", { format: "gzip" }));
     } else if (url == "/invalid_status_code") {
       client.send("HTTP/1.0 dead Not Found\r\n");
       client.send("\r\n");
@@ -192,6 +192,63 @@ test([
         assertEquals(error.request.statusLine, "HTTP/1.0 dead Not Found");
       };
     });
+  },
+
+  function () {
+    scoped(new HTTPServer, function () {
+      this.start();
+
+      var response = JSON.parse(URL.get(this.prefix + "/testing",
+                                        { accept_encoding: "gzip" }));
+
+      assertEquals("gzip", response.headers["Accept-Encoding"]);
+    });
+  },
+
+  function () {
+    scoped(new HTTPServer, function () {
+      this.start();
+
+      var response = JSON.parse(URL.get(this.prefix + "/testing",
+                                        { accept_encoding: false }));
+
+      assertFalse("Accept-Encoding" in response.headers);
+    });
+  },
+
+  function () {
+    if (typeof ZLib == "undefined")
+      return;
+
+    scoped(new HTTPServer, function () {
+      this.start();
+
+      var response = JSON.parse(URL.post(this.prefix + "/testing", "Hello world!",
+                                         { request_encoding: "gzip" }));
+
+      /* The server inflates the body before echoing it. */
+      assertEquals("gzip", response.headers["Content-Encoding"]);
+      assertEquals("Hello world!", response.body);
+
+      assertThrows(Object,
+                   "request encoding conflicts with Content-Encoding header",
+                   function () {
+                     URL.post(this.prefix + "/testing", "Hello world!",
+                              { request_encoding: "gzip",
+                                headers: { "Content-Encoding": "gzip" }});
+                   }.bind(this));
+    });
+  },
+
+  function () {
+    if (typeof ZLib == "undefined")
+      return;
+
+    scoped(new HTTPServer, function () {
+      this.start();
+
+      assertEquals("Hello world!", URL.get(this.prefix + "/gzipped"));
+    });
   }
 ]);
 
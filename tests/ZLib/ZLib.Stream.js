@@ -59,6 +59,49 @@ test([
     inflate.close();
 
     assertEquals(input.decode(), inflate.read().decode());
+  },
+
+  function () {
+    var deflate = new ZLib.Stream("deflate");
+    var input = IO.File.read("tests/input/repetetive.txt");
+
+    deflate.write(input);
+    deflate.close();
+
+    var inflate = new ZLib.Stream("inflate");
+
+    inflate.write(deflate.read());
+    inflate.close();
+
+    assertEquals(input.length, inflate.available);
+
+    var head = inflate.read(10);
+
+    assertEquals(10, head.length);
+    assertEquals(input.length - 10, inflate.available);
+
+    var rest = new Bytes(input.length - 10);
+
+    assertEquals(rest.length, inflate.readInto(rest));
+    assertEquals(0, inflate.available);
+    assertEquals(null, inflate.read());
+    assertEquals(input.decode(), head.concat(rest).decode());
+  },
+
+  function () {
+    var options = { format: "gzip", strategy: "filtered", memLevel: 9 };
+    var deflate = new ZLib.Stream("deflate", options);
+
+    deflate.write("Hello ");
+    deflate.write("world!");
+    deflate.close();
+
+    var inflate = new ZLib.Stream("inflate", { format: "auto" });
+
+    inflate.write(deflate.read());
+    inflate.close();
+
+    assertEquals("Hello world!", inflate.read().decode());
   }
 ]);
 
@@ -46,6 +46,113 @@ test([
     var deflated9 = ZLib.deflate(input, 9);
 
     assertTrue(deflated9.length < deflated1.length);
+  },
+
+  function () {
+    var deflated = ZLib.deflate("Hello world!", { format: "gzip" });
+
+    assertEquals(0x1f, deflated[0]);
+    assertEquals(0x8b, deflated[1]);
+    assertEquals("Hello world!",
+                 ZLib.inflate(deflated, { format: "gzip" }).decode());
+    assertEquals("Hello world!",
+                 ZLib.inflate(deflated, { format: "auto" }).decode());
+  },
+
+  function () {
+    var deflated = ZLib.deflate("Hello world!", { format: "raw", level: 9 });
+
+    assertEquals("Hello world!",
+                 ZLib.inflate(deflated, { format: "raw" }).decode());
+    assertThrows(Object, "Data error",
+                 function () { ZLib.inflate(deflated); });
+  },
+
+  function () {
+    var dictionary = '{"id":,"name":"","type":"user","active":true}';
+    var input = '{"id":17,"name":"foo","type":"user","active":true}';
+
+    var plain = ZLib.deflate(input);
+    var primed = ZLib.deflate(input, { dictionary: dictionary });
+
+    assertTrue(primed.length < plain.length);
+    assertThrows(Object, "Dictionary required",
+                 function () { ZLib.inflate(primed); });
+    assertEquals(input, ZLib.inflate(primed, { dictionary: dictionary })
+                 .decode());
+
+    var raw = ZLib.deflate(input, { format: "raw", dictionary: dictionary });
+
+    assertEquals(input, ZLib.inflate(raw, { format: "raw",
+                                            dictionary: dictionary })
+                 .decode());
+  },
+
+  function () {
+    var input = IO.File.read("tests/input/repetetive.txt");
+
+    while (input.length < 1024 * 1024)
+      input = input.concat(input);
+
+    ["zlib", "gzip", "raw"].forEach(function (format) {
+      var options = { format: format, threads: 4, blockSize: 65536 };
+      var serial = ZLib.deflate(input, { format: format });
+      var parallel = ZLib.deflate(input, options);
+
+      assertTrue(parallel.length < serial.length * 1.1);
+      assertEquals(input.decode(),
+                   ZLib.inflate(parallel, { format: format }).decode());
+    });
+  },
+
+  function () {
+    /* The zlib header's compression level field matches what deflate()
+       itself would write. */
+    var input = IO.File.read("tests/input/repetetive.txt");
+
+    while (input.length < 256 * 1024)
+      input = input.concat(input);
+
+    [0, 1, 2, 5, 6, 7, 9].forEach(function (level) {
+      var serial = ZLib.deflate(input, { level: level });
+      var parallel = ZLib.deflate(input, { level: level, threads: 2,
+                                           blockSize: 65536 });
+
+      assertEquals(serial[0], parallel[0]);
+      assertEquals(serial[1], parallel[1]);
+    });
+  },
+
+  function () {
+    var input = IO.File.read("tests/input/repetetive.txt");
+    var result = null, error = null;
+
+    ZLib.deflateAsync(input, { format: "gzip" }).then(function (deflated) {
+      return ZLib.inflateAsync(deflated, { format: "gzip" });
+    }).then(function (inflated) {
+      result = inflated;
+      return ZLib.inflateAsync(input);
+    }).catch(function (e) {
+      error = e;
+    });
+
+    runEventLoop();
+
+    assertEquals(input.decode(), result.decode());
+    assertEquals("Data error", error.message);
+  },
+
+  function () {
+    assertEquals(0xcbf43926, ZLib.crc32("123456789"));
+    assertEquals(0x091e01de, ZLib.adler32("123456789"));
+    assertEquals(0xe3069283, ZLib.crc32c("123456789"));
+
+    assertEquals(ZLib.crc32("123456789"),
+                 ZLib.crc32("56789", ZLib.crc32("1234")));
+    assertEquals(ZLib.adler32("123456789"),
+                 ZLib.adler32("56789", ZLib.adler32("1234")));
+    assertEquals(ZLib.crc32c("123456789"),
+                 ZLib.crc32c("56789", ZLib.crc32c("1234")));
   }
 ]);
 
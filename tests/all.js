@@ -28,6 +28,7 @@ if (typeof Testing != "undefined")
 Module.load("BuiltIn/BuiltIn.js");
 Module.load("IO/IO.js");
 Module.load("OS/OS.js");
+Module.load("Hash/Hash.js");
 
 if (typeof URL != "undefined")
   Module.load("URL/URL.js");
@@ -0,0 +1,146 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "utilities/Checksum.h"
+
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace utilities {
+
+namespace {
+
+const std::uint32_t kPolynomial = 0x82f63b78;
+
+/* Lookup tables for the portable slicing-by-8 implementation.  Table[0] is
+   the classic byte-wise table; table[n] advances a byte n positions further. */
+class Tables {
+ public:
+  Tables() {
+    for (unsigned index = 0; index < 256; ++index) {
+      std::uint32_t crc = index;
+      for (unsigned bit = 0; bit < 8; ++bit)
+        crc = (crc >> 1) ^ (kPolynomial & (0 - (crc & 1)));
+      table[0][index] = crc;
+    }
+
+    for (unsigned index = 0; index < 256; ++index)
+      for (unsigned slice = 1; slice < 8; ++slice)
+        table[slice][index] = (table[slice - 1][index] >> 8) ^
+            table[0][table[slice - 1][index] & 0xff];
+  }
+
+  std::uint32_t table[8][256];
+};
+
+const Tables tables;
+
+std::uint32_t Portable(std::uint32_t crc, const unsigned char* data,
+                       size_t length) {
+  const std::uint32_t (*table)[256] = tables.table;
+
+  while (length != 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+    crc = table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    --length;
+  }
+
+  while (length >= 8) {
+    std::uint32_t low, high;
+
+    memcpy(&low, data, 4);
+    memcpy(&high, data + 4, 4);
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    low = __builtin_bswap32(low);
+    high = __builtin_bswap32(high);
+#endif
+
+    low ^= crc;
+    crc = table[7][low & 0xff] ^
+          table[6][(low >> 8) & 0xff] ^
+          table[5][(low >> 16) & 0xff] ^
+          table[4][low >> 24] ^
+          table[3][high & 0xff] ^
+          table[2][(high >> 8) & 0xff] ^
+          table[1][(high >> 16) & 0xff] ^
+          table[0][high >> 24];
+
+    data += 8;
+    length -= 8;
+  }
+
+  while (length-- != 0)
+    crc = table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+  return crc;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2")))
+std::uint32_t Hardware(std::uint32_t crc, const unsigned char* data,
+                       size_t length) {
+  std::uint64_t crc64 = crc;
+
+  while (length != 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+    crc64 = _mm_crc32_u8(crc64, *data++);
+    --length;
+  }
+
+  while (length >= 8) {
+    std::uint64_t value;
+    memcpy(&value, data, 8);
+    crc64 = _mm_crc32_u64(crc64, value);
+    data += 8;
+    length -= 8;
+  }
+
+  while (length-- != 0)
+    crc64 = _mm_crc32_u8(crc64, *data++);
+
+  return crc64;
+}
+
+bool HasHardwareSupport() {
+  static const bool supported = __builtin_cpu_supports("sse4.2");
+  return supported;
+}
+
+#endif
+
+}
+
+std::uint32_t Checksum::CRC32C(std::uint32_t crc, const void* data,
+                               size_t length) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+  crc = ~crc;
+
+#if defined(__x86_64__)
+  if (HasHardwareSupport())
+    return ~Hardware(crc, bytes, length);
+#endif
+
+  return ~Portable(crc, bytes, length);
+}
+
+}
@@ -0,0 +1,40 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef UTILITIES_CHECKSUM_H
+#define UTILITIES_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utilities {
+
+class Checksum {
+ public:
+  static std::uint32_t CRC32C(std::uint32_t crc, const void* data,
+                              size_t length);
+  /**< Update 'crc' with 'length' bytes from 'data' using the Castagnoli
+       polynomial.  Pass zero as 'crc' to start a new checksum, or the result
+       of a previous call to continue one.  Uses the SSE4.2 crc32 instruction
+       where available. */
+};
+
+}
+
+#endif // UTILITIES_CHECKSUM_H
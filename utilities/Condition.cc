@@ -34,6 +34,10 @@ void Condition::Lock::Signal() {
   pthread_cond_signal(&condition_.condition_);
 }
 
+void Condition::Lock::Broadcast() {
+  pthread_cond_broadcast(&condition_.condition_);
+}
+
 Condition::Condition(Mutex& mutex)
     : mutex_(mutex) {
   pthread_cond_init(&condition_, NULL);
@@ -36,6 +36,7 @@ class Condition {
 
     void Wait();
     void Signal();
+    void Broadcast();
 
    private:
     Lock(const Lock&);
@@ -0,0 +1,382 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#include "Base.h"
+#include "utilities/Encoding.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace utilities {
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+const char kBase64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+const char kBase64URL[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+const signed char kInvalid = -1;
+const signed char kSkip = -2;
+const signed char kPadding = -3;
+
+class DecodeTables {
+ public:
+  DecodeTables() {
+    memset(hex, kInvalid, sizeof hex);
+    memset(base64, kInvalid, sizeof base64);
+
+    for (int index = 0; index < 16; ++index) {
+      hex[static_cast<unsigned char>(kHexDigits[index])] = index;
+      hex[toupper(kHexDigits[index])] = index;
+    }
+
+    for (int index = 0; index < 64; ++index) {
+      base64[static_cast<unsigned char>(kBase64[index])] = index;
+      base64[static_cast<unsigned char>(kBase64URL[index])] = index;
+    }
+
+    base64[' '] = base64['\t'] = base64['\r'] = base64['\n'] = kSkip;
+    base64['='] = kPadding;
+  }
+
+  signed char hex[256];
+  signed char base64[256];
+};
+
+const DecodeTables tables;
+
+/* Decode one UTF-8 sequence, advancing 'data'.  Malformed input yields
+   U+FFFD and consumes a single byte.  Surrogates are let through, since V8
+   produces them (encoded as three bytes) for unpaired surrogates. */
+std::uint32_t DecodeCharacter(const unsigned char*& data,
+                              const unsigned char* end) {
+  unsigned lead = *data;
+  unsigned length;
+  std::uint32_t character;
+
+  if (lead < 0x80) {
+    ++data;
+    return lead;
+  } else if (lead >= 0xc2 && lead < 0xe0) {
+    length = 2;
+    character = lead & 0x1f;
+  } else if (lead >= 0xe0 && lead < 0xf0) {
+    length = 3;
+    character = lead & 0x0f;
+  } else if (lead >= 0xf0 && lead < 0xf5) {
+    length = 4;
+    character = lead & 0x07;
+  } else {
+    ++data;
+    return 0xfffd;
+  }
+
+  if (static_cast<size_t>(end - data) < length) {
+    ++data;
+    return 0xfffd;
+  }
+
+  for (unsigned index = 1; index < length; ++index) {
+    if ((data[index] & 0xc0) != 0x80) {
+      ++data;
+      return 0xfffd;
+    }
+    character = (character << 6) | (data[index] & 0x3f);
+  }
+
+  if ((length == 3 && character < 0x800) ||
+      (length == 4 && (character < 0x10000 || character > 0x10ffff))) {
+    ++data;
+    return 0xfffd;
+  }
+
+  data += length;
+  return character;
+}
+
+/* Length of the run of ASCII bytes at the start of 'data'. */
+size_t ASCIIPrefix(const unsigned char* data, size_t length) {
+  size_t offset = 0;
+
+#if defined(__SSE2__)
+  while (length - offset >= 16) {
+    __m128i chunk = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + offset));
+    int mask = _mm_movemask_epi8(chunk);
+    if (mask != 0)
+      return offset + __builtin_ctz(mask);
+    offset += 16;
+  }
+#else
+  while (length - offset >= 8) {
+    std::uint64_t word;
+    memcpy(&word, data + offset, 8);
+    if ((word & 0x8080808080808080ull) != 0)
+      break;
+    offset += 8;
+  }
+#endif
+
+  while (offset < length && data[offset] < 0x80)
+    ++offset;
+
+  return offset;
+}
+
+}
+
+void Encoding::EncodeHex(const void* data_in, size_t length, char* target) {
+  const unsigned char* data = static_cast<const unsigned char*>(data_in);
+  size_t offset = 0;
+
+#if defined(__SSE2__)
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i letter = _mm_set1_epi8('a' - '0' - 10);
+
+  for (; length - offset >= 16; offset += 16) {
+    __m128i chunk = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + offset));
+    __m128i high = _mm_and_si128(_mm_srli_epi16(chunk, 4), mask);
+    __m128i low = _mm_and_si128(chunk, mask);
+
+    high = _mm_add_epi8(_mm_add_epi8(high, zero),
+                        _mm_and_si128(_mm_cmpgt_epi8(high, nine), letter));
+    low = _mm_add_epi8(_mm_add_epi8(low, zero),
+                       _mm_and_si128(_mm_cmpgt_epi8(low, nine), letter));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 2 * offset),
+                     _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(target + 2 * offset + 16),
+                     _mm_unpackhi_epi8(high, low));
+  }
+#endif
+
+  for (; offset < length; ++offset) {
+    target[2 * offset] = kHexDigits[data[offset] >> 4];
+    target[2 * offset + 1] = kHexDigits[data[offset] & 0x0f];
+  }
+}
+
+size_t Encoding::DecodeHex(const char* data, size_t length, void* target_in) {
+  unsigned char* target = static_cast<unsigned char*>(target_in);
+
+  if (length % 2 != 0)
+    throw Error("invalid hex string: odd length");
+
+  for (size_t offset = 0; offset < length; offset += 2) {
+    signed char high = tables.hex[static_cast<unsigned char>(data[offset])];
+    signed char low = tables.hex[static_cast<unsigned char>(data[offset + 1])];
+
+    if (high < 0 || low < 0)
+      throw Error("invalid hex string");
+
+    *target++ = (high << 4) | low;
+  }
+
+  return length / 2;
+}
+
+size_t Encoding::Base64Length(size_t length, bool url) {
+  if (url)
+    return (length * 4 + 2) / 3;
+  else
+    return (length + 2) / 3 * 4;
+}
+
+void Encoding::EncodeBase64(const void* data_in, size_t length, char* target,
+                            bool url) {
+  const unsigned char* data = static_cast<const unsigned char*>(data_in);
+  const char* alphabet = url ? kBase64URL : kBase64;
+  size_t offset = 0;
+
+  for (; length - offset >= 3; offset += 3) {
+    std::uint32_t group = (data[offset] << 16) | (data[offset + 1] << 8) |
+        data[offset + 2];
+
+    *target++ = alphabet[group >> 18];
+    *target++ = alphabet[(group >> 12) & 0x3f];
+    *target++ = alphabet[(group >> 6) & 0x3f];
+    *target++ = alphabet[group & 0x3f];
+  }
+
+  size_t remaining = length - offset;
+
+  if (remaining != 0) {
+    std::uint32_t group = data[offset] << 16;
+    if (remaining == 2)
+      group |= data[offset + 1] << 8;
+
+    *target++ = alphabet[group >> 18];
+    *target++ = alphabet[(group >> 12) & 0x3f];
+
+    if (remaining == 2)
+      *target++ = alphabet[(group >> 6) & 0x3f];
+    else if (!url)
+      *target++ = '=';
+
+    if (!url)
+      *target++ = '=';
+  }
+}
+
+size_t Encoding::DecodeBase64(const char* data, size_t length,
+                              void* target_in) {
+  unsigned char* target = static_cast<unsigned char*>(target_in);
+  unsigned char* start = target;
+  std::uint32_t group = 0;
+  unsigned count = 0;
+  bool padding = false;
+
+  for (size_t offset = 0; offset < length; ++offset) {
+    signed char value = tables.base64[static_cast<unsigned char>(data[offset])];
+
+    if (value == kSkip)
+      continue;
+    else if (value == kPadding)
+      padding = true;
+    else if (value == kInvalid || padding)
+      throw Error("invalid base64 string");
+    else {
+      group = (group << 6) | value;
+
+      if (++count == 4) {
+        *target++ = group >> 16;
+        *target++ = group >> 8;
+        *target++ = group;
+        group = 0;
+        count = 0;
+      }
+    }
+  }
+
+  switch (count) {
+    case 1:
+      throw Error("invalid base64 string");
+    case 2:
+      *target++ = group >> 4;
+      break;
+    case 3:
+      *target++ = group >> 10;
+      *target++ = group >> 2;
+      break;
+  }
+
+  return target - start;
+}
+
+bool Encoding::IsASCII(const void* data, size_t length) {
+  return ASCIIPrefix(static_cast<const unsigned char*>(data), length) ==
+      length;
+}
+
+bool Encoding::IsValidUTF8(const void* data_in, size_t length) {
+  const unsigned char* data = static_cast<const unsigned char*>(data_in);
+  const unsigned char* end = data + length;
+
+  while (data != end) {
+    data += ASCIIPrefix(data, end - data);
+    if (data == end)
+      break;
+
+    const unsigned char* before = data;
+    std::uint32_t character = DecodeCharacter(data, end);
+
+    /* DecodeCharacter() lets surrogates through; valid UTF-8 does not. */
+    if ((character == 0xfffd && data - before == 1) ||
+        (character >= 0xd800 && character < 0xe000))
+      return false;
+  }
+
+  return true;
+}
+
+size_t Encoding::UTF8ToLatin1(const char* data_in, size_t length,
+                              void* target_in) {
+  const unsigned char* data = reinterpret_cast<const unsigned char*>(data_in);
+  const unsigned char* end = data + length;
+  unsigned char* target = static_cast<unsigned char*>(target_in);
+  unsigned char* start = target;
+
+  while (data != end) {
+    size_t ascii = ASCIIPrefix(data, end - data);
+    memcpy(target, data, ascii);
+    target += ascii;
+    data += ascii;
+
+    if (data == end)
+      break;
+
+    std::uint32_t character = DecodeCharacter(data, end);
+    if (character > 0xff)
+      throw Error("character out of range for latin1");
+    *target++ = character;
+  }
+
+  return target - start;
+}
+
+size_t Encoding::UTF8ToUTF16LE(const char* data_in, size_t length,
+                               void* target_in) {
+  const unsigned char* data = reinterpret_cast<const unsigned char*>(data_in);
+  const unsigned char* end = data + length;
+  unsigned char* target = static_cast<unsigned char*>(target_in);
+  unsigned char* start = target;
+
+  while (data != end) {
+    size_t ascii = ASCIIPrefix(data, end - data);
+
+    for (size_t index = 0; index < ascii; ++index) {
+      *target++ = data[index];
+      *target++ = 0;
+    }
+    data += ascii;
+
+    if (data == end)
+      break;
+
+    std::uint32_t character = DecodeCharacter(data, end);
+
+    if (character >= 0x10000) {
+      character -= 0x10000;
+
+      std::uint16_t high = 0xd800 | (character >> 10);
+      std::uint16_t low = 0xdc00 | (character & 0x3ff);
+
+      *target++ = high;
+      *target++ = high >> 8;
+      *target++ = low;
+      *target++ = low >> 8;
+    } else {
+      *target++ = character;
+      *target++ = character >> 8;
+    }
+  }
+
+  return target - start;
+}
+
+}
@@ -0,0 +1,72 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+#ifndef UTILITIES_ENCODING_H
+#define UTILITIES_ENCODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace utilities {
+
+class Encoding {
+ public:
+  class Error {
+   public:
+    Error(std::string message)
+        : message_(message) {
+    }
+
+    const std::string& message() { return message_; }
+
+   private:
+    std::string message_;
+  };
+
+  static void EncodeHex(const void* data, size_t length, char* target);
+  /**< Write 2 * 'length' lowercase hexadecimal digits to 'target'. */
+  static size_t DecodeHex(const char* data, size_t length, void* target);
+  /**< Decode 'length' hexadecimal digits into 'length' / 2 bytes at 'target'
+       and return their number.  Throws Error on invalid input. */
+
+  static size_t Base64Length(size_t length, bool url);
+  /**< Length of the base64 encoding of 'length' bytes.  The URL-safe
+       variant is not padded. */
+  static void EncodeBase64(const void* data, size_t length, char* target,
+                           bool url);
+  static size_t DecodeBase64(const char* data, size_t length, void* target);
+  /**< Decode base64 (either alphabet, padded or not, with whitespace
+       ignored) into at most 3 * ceil('length' / 4) bytes at 'target' and
+       return their number.  Throws Error on invalid input. */
+
+  static bool IsASCII(const void* data, size_t length);
+  static bool IsValidUTF8(const void* data, size_t length);
+
+  static size_t UTF8ToLatin1(const char* data, size_t length, void* target);
+  /**< Transcode into at most 'length' bytes at 'target' and return their
+       number.  Throws Error for characters above U+00FF. */
+  static size_t UTF8ToUTF16LE(const char* data, size_t length, void* target);
+  /**< Transcode into at most 2 * 'length' bytes at 'target' and return their
+       number. */
+};
+
+}
+
+#endif // UTILITIES_ENCODING_H
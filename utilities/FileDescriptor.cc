@@ -22,6 +22,13 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include <algorithm>
 
 namespace utilities {
 
@@ -65,6 +72,222 @@ std::string FileDescriptor::ReadAll(int fd) {
   return ReadSome(fd, 0);
 }
 
+size_t FileDescriptor::ReadInto(int fd, void* buffer, size_t nbytes,
+                                bool async) {
+  char* data = static_cast<char*>(buffer);
+  size_t result = 0;
+
+  while (result < nbytes) {
+    ssize_t nread = ::read(fd, data + result, nbytes - result);
+
+    if (nread == -1) {
+      if (errno == EINTR)
+        continue;
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return result;
+      else
+        throw Error(errno);
+    }
+
+    if (nread == 0)
+      break;
+
+    result += nread;
+
+    if (async)
+      break;
+  }
+
+  if (!result && nbytes)
+    throw EndOfFile();
+
+  return result;
+}
+
+void FileDescriptor::Write(int fd, const void* data, size_t length) {
+  const char* buffer = static_cast<const char*>(data);
+
+  while (length) {
+    ssize_t nwritten = ::write(fd, buffer, length);
+
+    if (nwritten == -1) {
+      if (errno == EINTR)
+        continue;
+      else
+        throw Error(errno);
+    }
+
+    buffer += nwritten;
+    length -= nwritten;
+  }
+}
+
+void FileDescriptor::WriteVector(int fd, struct iovec* iov, int iovcnt) {
+  while (iovcnt) {
+    ssize_t nwritten = ::writev(fd, iov, std::min(iovcnt, IOV_MAX));
+
+    if (nwritten == -1) {
+      if (errno == EINTR)
+        continue;
+      else
+        throw Error(errno);
+    }
+
+    /* Skip the buffers that were written completely, and adjust the first
+       one that was written partially, if any. */
+    while (iovcnt && static_cast<size_t>(nwritten) >= iov->iov_len) {
+      nwritten -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+
+    if (iovcnt) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + nwritten;
+      iov->iov_len -= nwritten;
+    }
+  }
+}
+
+namespace {
+
+/* Upper limit on the amount of data handed to the kernel per system call;
+   sendfile() and friends transfer at most this much at a time anyway. */
+const std::uint64_t kMaximumChunk = 0x7ffff000;
+
+enum Method {
+  kCopyFileRange,
+  kSendFile,
+  kSplice,
+  kReadWrite
+};
+
+/* Errors that mean "this method doesn't work for these file descriptors"
+   rather than "the transfer failed". */
+bool IsUnsupported(int errnum) {
+  return errnum == EINVAL || errnum == ENOSYS || errnum == EXDEV ||
+         errnum == EOPNOTSUPP || errnum == ENOTSUP || errnum == ESPIPE ||
+         errnum == EBADF;
+}
+
+ssize_t TransferSome(Method method, int from, int to, size_t nbytes,
+                     std::int64_t* offset) {
+  switch (method) {
+    case kCopyFileRange:
+#if defined(SYS_copy_file_range)
+      {
+        loff_t off = offset ? *offset : 0;
+        ssize_t result = ::syscall(SYS_copy_file_range, from,
+                                   offset ? &off : NULL, to, NULL, nbytes, 0);
+        if (result > 0 && offset)
+          *offset = off;
+        return result;
+      }
+#else
+      errno = ENOSYS;
+      return -1;
+#endif
+
+    case kSendFile:
+      {
+        off_t off = offset ? *offset : 0;
+        ssize_t result = ::sendfile(to, from, offset ? &off : NULL, nbytes);
+        if (result > 0 && offset)
+          *offset = off;
+        return result;
+      }
+
+    case kSplice:
+      {
+        loff_t off = offset ? *offset : 0;
+        ssize_t result = ::splice(from, offset ? &off : NULL, to, NULL, nbytes,
+                                  SPLICE_F_MOVE);
+        if (result > 0 && offset)
+          *offset = off;
+        return result;
+      }
+
+    default:
+      {
+        char buffer[65536];
+        nbytes = std::min(nbytes, sizeof buffer);
+
+        ssize_t nread;
+        if (offset)
+          nread = ::pread(from, buffer, nbytes, *offset);
+        else
+          nread = ::read(from, buffer, nbytes);
+
+        if (nread <= 0)
+          return nread;
+
+        for (ssize_t nwritten = 0; nwritten < nread;) {
+          ssize_t retval = ::write(to, buffer + nwritten, nread - nwritten);
+          if (retval == -1) {
+            if (errno == EINTR)
+              continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+              /* The data has been consumed from 'from' and can't be put
+                 back, so wait until the rest can be written rather than
+                 report a short count and lose it. */
+              struct pollfd pfd;
+              pfd.fd = to;
+              pfd.events = POLLOUT;
+              if (::poll(&pfd, 1, -1) != -1 || errno == EINTR)
+                continue;
+            }
+            return -1;
+          }
+          nwritten += retval;
+        }
+
+        if (offset)
+          *offset += nread;
+        return nread;
+      }
+  }
+}
+
+}
+
+std::uint64_t FileDescriptor::Transfer(int from, int to, std::uint64_t nbytes,
+                                       std::int64_t* offset) {
+  Method method = kCopyFileRange;
+  std::uint64_t result = 0;
+  bool progress = false;
+
+  while (result < nbytes) {
+    size_t chunk = std::min(nbytes - result, kMaximumChunk);
+    ssize_t retval = TransferSome(method, from, to, chunk, offset);
+
+    if (retval == -1) {
+      if (errno == EINTR)
+        continue;
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      else if (!progress && method != kReadWrite && IsUnsupported(errno)) {
+        method = static_cast<Method>(method + 1);
+        continue;
+      } else
+        throw Error(errno);
+    }
+
+    if (retval == 0) {
+      /* Some file systems report zero from copy_file_range() instead of
+         failing; let the next method decide whether this really is EOF. */
+      if (!progress && method == kCopyFileRange) {
+        method = kSendFile;
+        continue;
+      }
+      break;
+    }
+
+    result += retval;
+    progress = true;
+  }
+
+  return result;
+}
+
 bool FileDescriptor::IsValid(int fd) {
   return ::fcntl(fd, F_GETFL) == 0 || errno != EBADF;
 }
@@ -20,8 +20,11 @@
 #ifndef UTILITIES_FILEDESCRIPTOR_H
 #define UTILITIES_FILEDESCRIPTOR_H
 
+#include <cstdint>
 #include <string>
 
+struct iovec;
+
 namespace utilities {
 
 class FileDescriptor {
@@ -52,6 +55,33 @@ class FileDescriptor {
   static std::string ReadAll(int fd);
   /**< Like ReadSome(), but with no upper limit on the number of bytes read. */
 
+  static size_t ReadInto(int fd, void* buffer, size_t nbytes,
+                         bool async = false);
+  /**< Like ReadSome(), but reads into 'buffer' instead of into a returned
+       string, and returns the number of bytes read.  Zero is returned in the
+       same situations as ReadSome() returns an empty string. */
+
+  static void Write(int fd, const void* data, size_t length);
+  /**< Write all of 'data' to 'fd', retrying after partial writes.  Throws an
+       Error object on failure. */
+
+  static void WriteVector(int fd, struct iovec* iov, int iovcnt);
+  /**< Like Write(), but writes a sequence of buffers with writev().  The
+       contents of 'iov' are modified. */
+
+  static std::uint64_t Transfer(int from, int to, std::uint64_t nbytes,
+                                std::int64_t* offset = NULL);
+  /**< Copy at most 'nbytes' bytes from 'from' to 'to', or until EOF, without
+       passing the data through a user-space buffer when the kernel allows it.
+       copy_file_range(), sendfile() and splice() are tried in turn, falling
+       back to a read()/write() loop.  If 'offset' is not NULL, reading starts
+       at that offset in 'from', whose file position is left unchanged, and
+       'offset' is advanced past the data copied.  Returns the number of bytes
+       copied, which is less than 'nbytes' only at EOF or if either file
+       descriptor is in non-blocking mode and would block; the read()/write()
+       fallback waits for 'to' rather than drop data it has already read.
+       Throws an Error object on failure. */
+
   static bool IsValid(int fd);
   /**< Return true if 'fd' is a valid file descriptor. */
 
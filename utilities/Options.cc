@@ -84,6 +84,14 @@ base::Object Options::GetObject(std::string name) const {
     return base::Object();
 }
 
+base::Variant Options::Get(std::string name) const {
+  auto iter(values_.find(name));
+  if (iter != values_.end())
+    return iter->second;
+  else
+    return base::Variant::Undefined();
+}
+
 Options::const_iterator Options::begin() const {
   return values_.begin();
 }
@@ -38,6 +38,7 @@ class Options {
   double GetNumber(std::string name, double default_value = 0) const;
   std::string GetString(std::string name, std::string default_value = "") const;
   base::Object GetObject(std::string name) const;
+  base::Variant Get(std::string name) const;
 
   typedef std::map<std::string, base::Variant>::const_iterator const_iterator;
 
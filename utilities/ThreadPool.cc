@@ -0,0 +1,300 @@
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#include "utilities/ThreadPool.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "utilities/Thread.h"
+
+namespace utilities {
+
+namespace {
+
+/* The pool and queue index of the current thread, if it is a pool thread. */
+thread_local ThreadPool* current_pool = NULL;
+thread_local unsigned current_index = 0;
+
+std::int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void UpdateMaximum(std::atomic<std::int64_t>& maximum, std::int64_t value) {
+  std::int64_t current = maximum.load(std::memory_order_relaxed);
+  while (value > current &&
+         !maximum.compare_exchange_weak(current, value,
+                                        std::memory_order_relaxed))
+    ;
+}
+
+}
+
+class ThreadPool::Worker : public Thread {
+ public:
+  Worker(ThreadPool& pool, unsigned index)
+      : pool_(pool)
+      , index_(index) {
+  }
+
+  virtual void Run() override {
+    current_pool = &pool_;
+    current_index = index_;
+    pool_.Work(index_);
+  }
+
+ private:
+  ThreadPool& pool_;
+  unsigned index_;
+};
+
+ThreadPool::ThreadPool(unsigned threads)
+    : condition_(mutex_)
+    , stopping_(false)
+    , pending_(0)
+    , sleeping_(0)
+    , next_queue_(0)
+    , running_(0)
+    , completed_(0)
+    , stolen_(0)
+    , total_wait_(0)
+    , max_wait_(0)
+    , total_run_(0)
+    , max_run_(0) {
+  threads = std::max(threads, 1u);
+
+  for (unsigned index = 0; index < threads; ++index)
+    queues_.emplace_back(new Queue);
+
+  for (unsigned index = 0; index < threads; ++index) {
+    workers_.emplace_back(new Worker(*this, index));
+    workers_.back()->Start();
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    Condition::Lock lock(condition_);
+    stopping_ = true;
+    lock.Broadcast();
+  }
+
+  for (auto iter(workers_.begin()); iter != workers_.end(); ++iter)
+    (*iter)->Join();
+}
+
+void ThreadPool::Submit(Task task) {
+  unsigned index;
+
+  if (current_pool == this)
+    index = current_index;
+  else
+    index = next_queue_++ % queues_.size();
+
+  Queue& queue(*queues_[index]);
+
+  {
+    Mutex::Lock lock(queue.mutex);
+    Entry entry = { task, Now() };
+    queue.entries.push_back(entry);
+  }
+
+  ++pending_;
+
+  /* A worker about to sleep increments 'sleeping_' before checking
+     'pending_', so either it sees the task, or this sees it and wakes it. */
+  if (sleeping_ != 0) {
+    Condition::Lock lock(condition_);
+    lock.Signal();
+  }
+}
+
+void ThreadPool::ForEach(size_t count, unsigned max_threads,
+                         const std::function<void (size_t)>& function) {
+  /* Shared with the helper tasks, some of which may not start until long
+     after this call has returned. */
+  struct State {
+    State(size_t count, const std::function<void (size_t)>& function)
+        : condition(mutex)
+        , next(0)
+        , count(count)
+        , function(function)
+        , running(0)
+        , finished(false) {
+    }
+
+    void Work() {
+      size_t index;
+      while ((index = next++) < count)
+        function(index);
+    }
+
+    Mutex mutex;
+    Condition condition;
+    std::atomic<size_t> next;
+    size_t count;
+    const std::function<void (size_t)>& function;
+    unsigned running;
+    bool finished;
+  };
+
+  std::shared_ptr<State> state(std::make_shared<State>(count, function));
+  unsigned helpers = std::min<size_t>(
+      std::min(max_threads, threads()), count);
+
+  /* The calling thread does its share of the work. */
+  if (helpers > 0)
+    --helpers;
+
+  for (unsigned index = 0; index < helpers; ++index)
+    Submit([state]() {
+      {
+        Condition::Lock lock(state->condition);
+        if (state->finished)
+          return;
+        ++state->running;
+      }
+
+      state->Work();
+
+      Condition::Lock lock(state->condition);
+      if (--state->running == 0)
+        lock.Signal();
+    });
+
+  state->Work();
+
+  /* All indexes have been claimed, by this thread or by helpers that have
+     started.  Wait only for the latter; helpers that start later find that
+     there's nothing left to do.  Waiting for helpers still queued could
+     deadlock if all pool threads were themselves in ForEach(). */
+  Condition::Lock lock(state->condition);
+  state->finished = true;
+  while (state->running != 0)
+    lock.Wait();
+}
+
+ThreadPool::Statistics ThreadPool::GetStatistics() {
+  Statistics statistics;
+
+  statistics.threads = threads();
+  statistics.queued = std::max(pending_.load(), 0L);
+  statistics.running = running_;
+  statistics.completed = completed_;
+  statistics.stolen = stolen_;
+  statistics.total_wait = total_wait_ / 1e6;
+  statistics.max_wait = max_wait_ / 1e6;
+  statistics.total_run = total_run_ / 1e6;
+  statistics.max_run = max_run_ / 1e6;
+
+  return statistics;
+}
+
+ThreadPool& ThreadPool::Shared() {
+  /* Never destroyed: threads blocked in a task at exit would otherwise keep
+     the process from exiting. */
+  static ThreadPool* pool = new ThreadPool(
+      std::max(::sysconf(_SC_NPROCESSORS_ONLN), 2L));
+  return *pool;
+}
+
+bool ThreadPool::Take(unsigned index, Entry& entry, bool& stolen) {
+  /* The newest task from the thread's own queue, whose data is most likely
+     to still be in cache... */
+  {
+    Queue& queue(*queues_[index]);
+    Mutex::Lock lock(queue.mutex);
+
+    if (!queue.entries.empty()) {
+      entry = std::move(queue.entries.back());
+      queue.entries.pop_back();
+      stolen = false;
+      return true;
+    }
+  }
+
+  /* ...or else the oldest task from some other thread's queue. */
+  for (unsigned offset = 1; offset < queues_.size(); ++offset) {
+    Queue& queue(*queues_[(index + offset) % queues_.size()]);
+    Mutex::Lock lock(queue.mutex);
+
+    if (!queue.entries.empty()) {
+      entry = std::move(queue.entries.front());
+      queue.entries.pop_front();
+      stolen = true;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::Execute(Entry& entry, bool stolen) {
+  --pending_;
+  ++running_;
+
+  std::int64_t started_at = Now();
+  std::int64_t wait = started_at - entry.queued_at;
+
+  try {
+    entry.task();
+  } catch (...) {
+    /* Tasks must not throw, but an exception escaping here would terminate
+       the process. */
+  }
+
+  std::int64_t run = Now() - started_at;
+
+  total_wait_ += wait;
+  UpdateMaximum(max_wait_, wait);
+  total_run_ += run;
+  UpdateMaximum(max_run_, run);
+
+  if (stolen)
+    ++stolen_;
+  ++completed_;
+  --running_;
+}
+
+void ThreadPool::Work(unsigned index) {
+  while (true) {
+    Entry entry;
+    bool stolen;
+
+    if (Take(index, entry, stolen)) {
+      Execute(entry, stolen);
+      continue;
+    }
+
+    Condition::Lock lock(condition_);
+
+    ++sleeping_;
+    while (!stopping_ && pending_ <= 0)
+      lock.Wait();
+    --sleeping_;
+
+    if (stopping_ && pending_ <= 0)
+      return;
+  }
+}
+
+}
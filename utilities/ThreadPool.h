@@ -0,0 +1,119 @@
+/* -*- mode: c++ -*- */
+/*
+
+  Copyright 2013 Jens Lindström
+
+  Licensed under the Apache License, Version 2.0 (the "License"); you may not
+  use this file except in compliance with the License.  You may obtain a copy of
+  the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+  License for the specific language governing permissions and limitations under
+  the License.
+
+*/
+
+
+#ifndef UTILITIES_THREADPOOL_H
+#define UTILITIES_THREADPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "utilities/Condition.h"
+#include "utilities/Mutex.h"
+
+namespace utilities {
+
+class ThreadPool {
+ public:
+  typedef std::function<void ()> Task;
+
+  struct Statistics {
+    unsigned threads;
+    size_t queued;
+    size_t running;
+    std::uint64_t completed;
+    std::uint64_t stolen;
+
+    /* Time, in milliseconds, that completed tasks spent queued and running,
+       in total and at most. */
+    double total_wait;
+    double max_wait;
+    double total_run;
+    double max_run;
+  };
+
+  explicit ThreadPool(unsigned threads);
+  ~ThreadPool();
+  /**< Waits for all queued tasks to finish. */
+
+  void Submit(Task task);
+  /**< Run 'task' on one of the pool's threads.  Tasks submitted from one of
+       the pool's threads are queued on that thread's own queue, others are
+       spread over all queues; idle threads steal tasks from other threads'
+       queues.  Tasks must not touch the isolate, and must not throw. */
+
+  void ForEach(size_t count, unsigned max_threads,
+               const std::function<void (size_t)>& function);
+  /**< Call 'function' once for each index below 'count', on the calling
+       thread and up to 'max_threads - 1' of the pool's threads, and return
+       when all calls have returned.  May be called from a pool thread. */
+
+  Statistics GetStatistics();
+
+  unsigned threads() const { return workers_.size(); }
+
+  static ThreadPool& Shared();
+  /**< Return the process-wide pool, created on first use with one thread per
+       CPU, but at least two, so that slow blocking calls (like DNS lookups)
+       don't hold up everything else. */
+
+ private:
+  class Worker;
+
+  struct Entry {
+    Task task;
+    std::int64_t queued_at;
+  };
+
+  struct Queue {
+    Mutex mutex;
+    std::deque<Entry> entries;
+  };
+
+  bool Take(unsigned index, Entry& entry, bool& stolen);
+  void Execute(Entry& entry, bool stolen);
+  void Work(unsigned index);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  Mutex mutex_;
+  Condition condition_;
+  bool stopping_;
+
+  std::atomic<long> pending_;
+  std::atomic<unsigned> sleeping_;
+  std::atomic<unsigned> next_queue_;
+
+  std::atomic<size_t> running_;
+  std::atomic<std::uint64_t> completed_;
+  std::atomic<std::uint64_t> stolen_;
+  std::atomic<std::int64_t> total_wait_;
+  std::atomic<std::int64_t> max_wait_;
+  std::atomic<std::int64_t> total_run_;
+  std::atomic<std::int64_t> max_run_;
+};
+
+}
+
+#endif // UTILITIES_THREADPOOL_H
@@ -20,4 +20,7 @@ common_sources += utilities/Formatter.cc \
                   utilities/Thread.cc \
                   utilities/Mutex.cc \
                   utilities/Condition.cc \
-                  utilities/Options.cc
+                  utilities/ThreadPool.cc \
+                  utilities/Options.cc \
+                  utilities/Checksum.cc \
+                  utilities/Encoding.cc